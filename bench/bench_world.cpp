@@ -0,0 +1,604 @@
+// Headless world benchmark: steps the simulation of every shipped level and of bigger synthetic
+// levels with a fixed seed and a fixed time step, without a window, audio or textures.
+// Usage: bench_world [--frames 5000] [--warmup 120] [--seed 1234] [--threads N] [--out dist/bench_world.json]
+//                    [--level resources/worlds/generated/stress_256 ...] [--replay session.replay]
+//                    [--alloc-budget N] [--rewind]
+// Run it from the repository root (make bench), the levels are read from resources/worlds.
+// --level adds a level by the prefix of its CSVs, like the ones written by make levelgen.
+// --replay plays back a session recorded with the game's --record instead, times it and
+// checks that the world goes through the recorded states (exit code 2 when it doesn't).
+// Built with make bench ALLOC_TRACKING=1 it also counts the heap allocations of every step, and
+// --alloc-budget N fails the run (exit code 3) when a step of any level allocates more than N times.
+// --rewind also records every step in a WorldHistory, like the game does, times it and at the end
+// rewinds the whole history checking every state on the way back (exit code 4 when one differs).
+// Built with make bench TILE_STATE_BITS=16 (or 8) TILE_STATE_VALIDATE=1 it reports how often the
+// quantized tile states end up in another band than the float ones, and their largest difference.
+
+#include "raylib.h"
+#include "raymath.h"
+#include "world.h"
+#include "Replay.h"
+#include "AllocTracker.h"
+#include "Rewind.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+inline constexpr float BENCH_DELTA_TIME = 1.0f / 60.0f;
+inline constexpr int BENCH_LEVELS = 11;
+inline constexpr int BENCH_MAX_THREADS = 16;
+
+struct BenchLevel
+{
+    std::string name;
+    int level;
+    LevelMatrix ground;
+    LevelMatrix entities;
+};
+
+struct BenchResult
+{
+    std::string name;
+    int width = 0;
+    int height = 0;
+    int frames = 0;
+    double seconds = 0.0;
+    double meanMs = 0.0;
+    double p50Ms = 0.0;
+    double p99Ms = 0.0;
+    double maxMs = 0.0;
+    int restarts = 0;
+    long long tileChanges = 0;
+    long long healthChanges = 0;
+    long long grabs = 0;
+    double allocationsPerStep = 0.0;
+    double bytesPerStep = 0.0;
+    uint64_t maxStepAllocations = 0;
+    double recordP99Ms = 0.0;
+    double historyBytesPerStep = 0.0;
+    double rewindStepsPerSecond = 0.0;
+    long long rewindMismatches = 0;
+    double bandMismatchRate = 0.0;
+    double maxTileStateError = 0.0;
+};
+
+// Counts the events instead of playing sounds, the counts make runs comparable
+class CountingEvents : public WorldEventSink
+{
+public:
+    long long tileChanges = 0;
+    long long healthChanges = 0;
+    long long grabs = 0;
+
+    void OnTileChanged(World *world, Rectangle where, TileType from, TileType to) override { tileChanges++; }
+    void OnPlayerHealthChanged(World *world, float lastHealth, float newHealth) override { healthChanges++; }
+    void OnElementalGrabbed(World *world, const Elemental &elemental) override { grabs++; }
+};
+
+// Wanders around, grabs and releases whatever is close and waves the staff around the player
+class ScriptedInput
+{
+private:
+    std::mt19937 random;
+    Vector2 move = {0, 0};
+
+public:
+    explicit ScriptedInput(uint32_t seed) : random(seed) {}
+
+    WorldInput Next(const World *world, int frame)
+    {
+        if (frame % 90 == 0)
+        {
+            std::uniform_int_distribution<int> axis(-1, 1);
+            move = Vector2{static_cast<float>(axis(random)), static_cast<float>(axis(random))};
+        }
+
+        WorldInput input;
+        input.move = move;
+        input.interact = frame % 240 == 0;
+        float angle = frame * 0.05f;
+        input.pointer = Vector2Add(world->player.position, Vector2{cosf(angle) * 3 * TILE_SIZE, sinf(angle) * 3 * TILE_SIZE});
+        return input;
+    }
+};
+
+static World *StartWorld(const BenchLevel &level, uint32_t seed, CountingEvents *events)
+{
+    World *world = CreateWorld(level.level, level.ground, level.entities);
+    SeedWorld(world, seed);
+    world->events = events;
+    return world;
+}
+
+static double Percentile(const std::vector<double> &sorted, double fraction)
+{
+    if (sorted.empty())
+    {
+        return 0.0;
+    }
+    size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+// Takes the world back through the whole history, every state has to hash like on the way forward
+static void RewindAll(World *world, WorldHistory &history, std::vector<uint64_t> &hashes, BenchResult &result)
+{
+    int rewound = 0;
+    double seconds = 0.0;
+    hashes.pop_back();
+    while (history.GetSteps() > 0)
+    {
+        auto start = std::chrono::steady_clock::now();
+        history.Rewind(world);
+        seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        rewound++;
+        if (HashWorld(world) != hashes.back())
+        {
+            result.rewindMismatches++;
+        }
+        hashes.pop_back();
+    }
+    result.rewindStepsPerSecond = seconds > 0.0 ? rewound / seconds : 0.0;
+}
+
+static BenchResult RunLevel(const BenchLevel &level, int frames, int warmup, uint32_t seed, bool rewind)
+{
+    CountingEvents events;
+    ScriptedInput script(seed);
+    World *world = StartWorld(level, seed, &events);
+    // Restarts go back to it, like the game does
+    WorldSnapshot pristine;
+    SaveWorld(world, pristine);
+
+    BenchResult result;
+    result.name = level.name;
+    result.width = world->width;
+    result.height = world->height;
+    result.frames = frames;
+
+    std::vector<double> steps;
+    steps.reserve(frames);
+    WorldHistory history;
+    std::vector<double> records;
+    // Hash after every recorded step, the oldest ones go with the steps the history drops
+    std::vector<uint64_t> hashes;
+    if (rewind)
+    {
+        records.reserve(frames);
+        history.Record(world);
+        hashes.push_back(HashWorld(world));
+    }
+
+    for (int frame = 0; frame < warmup + frames; frame++)
+    {
+        // Keep the simulation busy, a finished level only counts its victory timer
+        if (world->player.mortalEntity.isDead || VictoryCondition(world))
+        {
+            RestoreWorld(world, pristine);
+            SeedWorld(world, seed + ++result.restarts);
+            if (rewind)
+            {
+                history.Reset();
+                history.Record(world);
+                hashes.assign(1, HashWorld(world));
+            }
+        }
+
+        world->input = script.Next(world, frame);
+#if defined(ENABLE_ALLOC_TRACKING)
+        // Per thread, so the worlds stepped in parallel don't count each other's allocations
+        auto allocsBefore = AllocTracker::GetThreadTotal();
+#endif
+        auto start = std::chrono::steady_clock::now();
+        UpdateWorld(world, BENCH_DELTA_TIME);
+        auto end = std::chrono::steady_clock::now();
+
+        if (rewind)
+        {
+            size_t bytesBefore = history.GetBytes();
+            auto recordStart = std::chrono::steady_clock::now();
+            history.Record(world);
+            auto recordEnd = std::chrono::steady_clock::now();
+            if (frame >= warmup)
+            {
+                records.push_back(std::chrono::duration<double, std::milli>(recordEnd - recordStart).count());
+                // Evicted records make this an underestimate only once the buffer is full
+                result.historyBytesPerStep += history.GetBytes() > bytesBefore ? history.GetBytes() - bytesBefore : 0;
+            }
+            hashes.push_back(HashWorld(world));
+            if (hashes.size() > static_cast<size_t>(history.GetSteps()) + 1)
+            {
+                hashes.erase(hashes.begin(), hashes.end() - history.GetSteps() - 1);
+            }
+        }
+
+        if (frame >= warmup)
+        {
+            steps.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+#if defined(ENABLE_ALLOC_TRACKING)
+            auto allocsAfter = AllocTracker::GetThreadTotal();
+            uint64_t allocations = allocsAfter.allocations - allocsBefore.allocations;
+            result.allocationsPerStep += allocations;
+            result.bytesPerStep += allocsAfter.bytes - allocsBefore.bytes;
+            result.maxStepAllocations = std::max(result.maxStepAllocations, allocations);
+#endif
+        }
+    }
+#if defined(ENABLE_TILE_STATE_VALIDATION)
+    const auto &drift = world->tileStateDrift;
+    result.bandMismatchRate = drift.tilesClassified > 0 ? static_cast<double>(drift.bandMismatches) / drift.tilesClassified : 0.0;
+    result.maxTileStateError = drift.maxError;
+#endif
+    if (rewind)
+    {
+        RewindAll(world, history, hashes, result);
+        std::sort(records.begin(), records.end());
+        result.recordP99Ms = Percentile(records, 0.99);
+        result.historyBytesPerStep = records.empty() ? 0.0 : result.historyBytesPerStep / records.size();
+    }
+    DeleteWorld(world);
+
+    double total = 0.0;
+    for (double step : steps)
+    {
+        total += step;
+    }
+    std::sort(steps.begin(), steps.end());
+
+    result.seconds = total / 1000.0;
+    result.meanMs = steps.empty() ? 0.0 : total / steps.size();
+    result.p50Ms = Percentile(steps, 0.50);
+    result.p99Ms = Percentile(steps, 0.99);
+    result.maxMs = steps.empty() ? 0.0 : steps.back();
+    result.allocationsPerStep = steps.empty() ? 0.0 : result.allocationsPerStep / steps.size();
+    result.bytesPerStep = steps.empty() ? 0.0 : result.bytesPerStep / steps.size();
+    result.tileChanges = events.tileChanges;
+    result.healthChanges = events.healthChanges;
+    result.grabs = events.grabs;
+    return result;
+}
+
+// Repeats the level factor x factor times, only the first copy keeps the player
+static BenchLevel ScaleLevel(const BenchLevel &source, int factor)
+{
+    BenchLevel scaled;
+    scaled.name = source.name + "_x" + std::to_string(factor);
+    scaled.level = source.level;
+
+    int height = static_cast<int>(source.ground.size());
+    int width = height > 0 ? static_cast<int>(source.ground[0].size()) : 0;
+    scaled.ground.assign(height * factor, std::pmr::vector<int>(width * factor));
+    scaled.entities.assign(height * factor, std::pmr::vector<int>(width * factor));
+
+    for (int y = 0; y < height * factor; y++)
+    {
+        for (int x = 0; x < width * factor; x++)
+        {
+            int sourceY = y % height;
+            int sourceX = x % width;
+            scaled.ground[y][x] = source.ground[sourceY][sourceX];
+
+            int entity = 0;
+            if (sourceY < static_cast<int>(source.entities.size()) && sourceX < static_cast<int>(source.entities[sourceY].size()))
+            {
+                entity = source.entities[sourceY][sourceX];
+            }
+            bool firstCopy = y < height && x < width;
+            scaled.entities[y][x] = entity == 1 && !firstCopy ? 0 : entity;
+        }
+    }
+    return scaled;
+}
+
+static bool LoadLevel(const std::string &prefix, int number, BenchLevel &loaded)
+{
+    int width = 0;
+    int height = 0;
+    loaded.name = prefix.substr(prefix.find_last_of('/') + 1);
+    loaded.level = number;
+    loaded.ground = LoadDataMatrix(prefix + "_ground.csv", width, height);
+    loaded.entities = LoadDataMatrix(prefix + "_entities.csv", width, height);
+    return !loaded.ground.empty();
+}
+
+static std::vector<BenchLevel> LoadLevels()
+{
+    std::vector<BenchLevel> levels;
+    for (int level = 1; level <= BENCH_LEVELS; level++)
+    {
+        BenchLevel loaded;
+        if (LoadLevel("resources/worlds/level_" + std::to_string(level), level, loaded))
+        {
+            levels.push_back(std::move(loaded));
+        }
+    }
+    return levels;
+}
+
+static int RunReplay(const char *path, const char *outPath)
+{
+    Replay replay;
+    BenchLevel level;
+    if (!LoadReplay(path, replay))
+    {
+        std::cerr << "Unable to load the replay " << path << std::endl;
+        return 1;
+    }
+    if (!LoadLevel("resources/worlds/level_" + std::to_string(replay.level), replay.level, level))
+    {
+        std::cerr << "Unable to load level " << replay.level << std::endl;
+        return 1;
+    }
+
+    CountingEvents events;
+    World *world = StartWorld(level, replay.seed, &events);
+    std::vector<double> steps;
+    steps.reserve(replay.inputs.size());
+    long divergedStep = -1;
+
+    for (size_t step = 0; step < replay.inputs.size(); step++)
+    {
+        world->input = replay.inputs[step];
+        auto start = std::chrono::steady_clock::now();
+        UpdateWorld(world, replay.timestep);
+        auto end = std::chrono::steady_clock::now();
+        steps.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+
+        uint64_t expected = 0;
+        if (divergedStep < 0 && GetReplayHash(replay, step, expected) && expected != HashWorld(world))
+        {
+            divergedStep = static_cast<long>(step);
+        }
+    }
+    uint64_t finalHash = HashWorld(world);
+    DeleteWorld(world);
+
+    double total = 0.0;
+    for (double step : steps)
+    {
+        total += step;
+    }
+    std::sort(steps.begin(), steps.end());
+    double fps = total > 0.0 ? steps.size() / (total / 1000.0) : 0.0;
+
+    fprintf(stderr, "Replay of level %d, %zu steps: %.1f fps  p50 %.4f ms  p99 %.4f ms  %s\n", replay.level,
+            steps.size(), fps, Percentile(steps, 0.50), Percentile(steps, 0.99),
+            divergedStep < 0 ? "matches the recording" : "DIVERGED");
+
+    FILE *file = fopen(outPath, "w");
+    if (file != nullptr)
+    {
+        fprintf(file,
+                "{\n  \"replay\": \"%s\",\n  \"level\": %d,\n  \"seed\": %u,\n  \"steps\": %zu,\n  \"fps\": %.1f,\n"
+                "  \"p50_ms\": %.5f,\n  \"p99_ms\": %.5f,\n  \"final_hash\": \"%016llx\",\n"
+                "  \"matches\": %s,\n  \"diverged_step\": %ld\n}\n",
+                path, replay.level, replay.seed, steps.size(), fps, Percentile(steps, 0.50), Percentile(steps, 0.99),
+                static_cast<unsigned long long>(finalHash), divergedStep < 0 ? "true" : "false", divergedStep);
+        fclose(file);
+    }
+    return divergedStep < 0 ? 0 : 2;
+}
+
+static void WriteResult(FILE *file, const BenchResult &result, bool last)
+{
+    fprintf(file,
+            "    {\"name\": \"%s\", \"width\": %d, \"height\": %d, \"frames\": %d, \"fps\": %.1f, "
+            "\"mean_ms\": %.5f, \"p50_ms\": %.5f, \"p99_ms\": %.5f, \"max_ms\": %.5f, "
+            "\"restarts\": %d, \"tile_changes\": %lld, \"health_changes\": %lld, \"grabs\": %lld, "
+            "\"allocs_per_step\": %.2f, \"alloc_bytes_per_step\": %.1f, \"max_step_allocs\": %llu, "
+            "\"record_p99_ms\": %.5f, \"history_bytes_per_step\": %.1f, \"rewind_steps_per_s\": %.1f, "
+            "\"rewind_mismatches\": %lld, \"tile_state_bits\": %d, \"band_mismatch_rate\": %.6f, "
+            "\"max_tile_state_error\": %.6f}%s\n",
+            result.name.c_str(), result.width, result.height, result.frames,
+            result.seconds > 0.0 ? result.frames / result.seconds : 0.0,
+            result.meanMs, result.p50Ms, result.p99Ms, result.maxMs,
+            result.restarts, result.tileChanges, result.healthChanges, result.grabs,
+            result.allocationsPerStep, result.bytesPerStep, static_cast<unsigned long long>(result.maxStepAllocations),
+            result.recordP99Ms, result.historyBytesPerStep, result.rewindStepsPerSecond, result.rewindMismatches,
+            static_cast<int>(sizeof(TileState) * 8), result.bandMismatchRate, result.maxTileStateError,
+            last ? "" : ",");
+}
+
+int main(int argc, char **argv)
+{
+    int frames = 5000;
+    int warmup = 120;
+    uint32_t seed = 1234;
+    int maxThreads = static_cast<int>(std::thread::hardware_concurrency());
+    const char *outPath = "dist/bench_world.json";
+    std::vector<std::string> extraLevels;
+    const char *replayPath = nullptr;
+    long long allocBudget = -1;
+    bool rewind = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            frames = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+            warmup = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            seed = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            maxThreads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+            outPath = argv[++i];
+        else if (strcmp(argv[i], "--level") == 0 && i + 1 < argc)
+            extraLevels.push_back(argv[++i]);
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+            replayPath = argv[++i];
+        else if (strcmp(argv[i], "--alloc-budget") == 0 && i + 1 < argc)
+            allocBudget = atoll(argv[++i]);
+        else if (strcmp(argv[i], "--rewind") == 0)
+            rewind = true;
+        else
+        {
+            std::cerr << "Unknown argument " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+    maxThreads = std::clamp(maxThreads, 1, BENCH_MAX_THREADS);
+#if !defined(ENABLE_ALLOC_TRACKING)
+    if (allocBudget >= 0)
+    {
+        std::cerr << "--alloc-budget needs the allocation tracker, build with make bench ALLOC_TRACKING=1" << std::endl;
+        return 1;
+    }
+#endif
+
+    SetTraceLogLevel(LOG_WARNING);
+
+    if (replayPath != nullptr)
+    {
+        return RunReplay(replayPath, outPath);
+    }
+
+    auto levels = LoadLevels();
+    if (levels.empty())
+    {
+        std::cerr << "No levels found, run the benchmark from the repository root" << std::endl;
+        return 1;
+    }
+
+    auto largest = std::max_element(levels.begin(), levels.end(), [](const BenchLevel &a, const BenchLevel &b) {
+        return a.ground.size() * a.ground[0].size() < b.ground.size() * b.ground[0].size();
+    });
+    BenchLevel scalingLevel = ScaleLevel(*largest, 4);
+    std::vector<BenchLevel> synthetic = {ScaleLevel(*largest, 2), scalingLevel, ScaleLevel(*largest, 8)};
+    for (const auto &prefix : extraLevels)
+    {
+        BenchLevel loaded;
+        if (!LoadLevel(prefix, 0, loaded))
+        {
+            std::cerr << "Unable to load " << prefix << "_ground.csv" << std::endl;
+            return 1;
+        }
+        synthetic.push_back(std::move(loaded));
+    }
+
+    std::vector<BenchResult> results;
+    for (const auto *group : {&levels, &synthetic})
+    {
+        for (const auto &level : *group)
+        {
+            results.push_back(RunLevel(level, frames, warmup, seed, rewind));
+            const auto &result = results.back();
+            fprintf(stderr, "%-16s %4dx%-4d %10.1f fps  p50 %.4f ms  p99 %.4f ms", result.name.c_str(),
+                    result.width, result.height, result.frames / result.seconds, result.p50Ms, result.p99Ms);
+#if defined(ENABLE_ALLOC_TRACKING)
+            fprintf(stderr, "  %.2f allocs/step (max %llu)", result.allocationsPerStep,
+                    static_cast<unsigned long long>(result.maxStepAllocations));
+#endif
+#if defined(ENABLE_TILE_STATE_VALIDATION)
+            fprintf(stderr, "  %.4f%% bands off (max error %.4f)", result.bandMismatchRate * 100.0, result.maxTileStateError);
+#endif
+            if (rewind)
+            {
+                fprintf(stderr, "  record p99 %.4f ms  %.0f B/step  rewind %.0f steps/s%s", result.recordP99Ms,
+                        result.historyBytesPerStep, result.rewindStepsPerSecond,
+                        result.rewindMismatches > 0 ? "  MISMATCH" : "");
+            }
+            fprintf(stderr, "\n");
+        }
+    }
+
+    // Independent worlds on every thread, the simulation shares no state between worlds
+    struct ScalingResult
+    {
+        int threads;
+        double totalFps;
+        double efficiency;
+    };
+    std::vector<ScalingResult> scaling;
+    double singleFps = 0.0;
+    for (int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        std::vector<BenchResult> perThread(threads);
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; t++)
+        {
+            workers.emplace_back([&, t]() {
+                perThread[t] = RunLevel(scalingLevel, frames, warmup, seed + t, false);
+            });
+        }
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+
+        double totalFps = 0.0;
+        for (const auto &result : perThread)
+        {
+            totalFps += result.frames / result.seconds;
+        }
+        if (threads == 1)
+        {
+            singleFps = totalFps;
+        }
+        double efficiency = singleFps > 0.0 ? totalFps / (singleFps * threads) : 0.0;
+        scaling.push_back({threads, totalFps, efficiency});
+        fprintf(stderr, "%2d threads %12.1f fps total  %5.1f%% efficiency\n", threads, totalFps, efficiency * 100.0);
+    }
+
+    FILE *file = fopen(outPath, "w");
+    if (file == nullptr)
+    {
+        std::cerr << "Unable to write " << outPath << std::endl;
+        return 1;
+    }
+    fprintf(file, "{\n  \"frames\": %d,\n  \"warmup\": %d,\n  \"seed\": %u,\n  \"delta_time\": %.6f,\n",
+            frames, warmup, seed, BENCH_DELTA_TIME);
+#if defined(ENABLE_ALLOC_TRACKING)
+    fprintf(file, "  \"alloc_budget\": %lld,\n  \"peak_live_bytes\": %lld,\n", allocBudget,
+            static_cast<long long>(AllocTracker::GetPeakLiveBytes()));
+#endif
+    fprintf(file, "  \"levels\": [\n");
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        WriteResult(file, results[i], i + 1 == results.size());
+    }
+    fprintf(file, "  ],\n  \"scaling\": {\n    \"level\": \"%s\",\n    \"runs\": [\n", scalingLevel.name.c_str());
+    for (size_t i = 0; i < scaling.size(); i++)
+    {
+        fprintf(file, "      {\"threads\": %d, \"total_fps\": %.1f, \"efficiency\": %.3f}%s\n",
+                scaling[i].threads, scaling[i].totalFps, scaling[i].efficiency, i + 1 == scaling.size() ? "" : ",");
+    }
+    fprintf(file, "    ]\n  }\n}\n");
+    fclose(file);
+
+    std::cout << "Wrote " << outPath << std::endl;
+
+    // Checked after writing the results, they show which levels went over
+    int overBudget = 0;
+    for (const auto &result : results)
+    {
+        if (allocBudget >= 0 && result.maxStepAllocations > static_cast<uint64_t>(allocBudget))
+        {
+            fprintf(stderr, "%s: a step made %llu allocations, over the budget of %lld\n", result.name.c_str(),
+                    static_cast<unsigned long long>(result.maxStepAllocations), allocBudget);
+            overBudget++;
+        }
+    }
+    int mismatched = 0;
+    for (const auto &result : results)
+    {
+        if (result.rewindMismatches > 0)
+        {
+            fprintf(stderr, "%s: %lld rewound steps differ from the recorded ones\n", result.name.c_str(),
+                    result.rewindMismatches);
+            mismatched++;
+        }
+    }
+    if (mismatched > 0)
+    {
+        return 4;
+    }
+    return overBudget > 0 ? 3 : 0;
+}
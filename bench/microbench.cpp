@@ -0,0 +1,401 @@
+// Microbenchmarks of the engine hot spots, each one measured in isolation without a window.
+// Usage: microbench [--repetitions 15] [--warmup 3] [--filter name] [--out dist/microbench.json]
+// Run it from the repository root (make microbench).
+//
+// Every benchmark runs its untimed setup, then times a fixed amount of work. After the warmup
+// repetitions are discarded the time per operation is reported as the median of the rest,
+// with the spread (standard deviation relative to the mean) so noisy results stand out.
+
+#include "raylib.h"
+#include "world.h"
+#include "utils.h"
+#include "FxManager.h"
+#include "Scheduler.h"
+#include "SoundManager.h"
+#include "ParticleSystem.h"
+#include "RichText.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Keeps the compiler from removing work whose result is unused
+template <typename T>
+inline void KeepAlive(const T &value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct Benchmark
+{
+    std::string name;
+    int operations; // Per repetition, the results are per operation
+    std::function<void()> setup;
+    std::function<void()> run;
+};
+
+struct BenchmarkResult
+{
+    std::string name;
+    int operations = 0;
+    double medianNs = 0.0;
+    double meanNs = 0.0;
+    double stddevNs = 0.0;
+    double minNs = 0.0;
+    double maxNs = 0.0;
+};
+
+static BenchmarkResult Measure(const Benchmark &benchmark, int warmup, int repetitions)
+{
+    std::vector<double> samples;
+    samples.reserve(repetitions);
+
+    for (int i = 0; i < warmup + repetitions; i++)
+    {
+        if (benchmark.setup)
+        {
+            benchmark.setup();
+        }
+        auto start = std::chrono::steady_clock::now();
+        benchmark.run();
+        auto end = std::chrono::steady_clock::now();
+
+        if (i >= warmup)
+        {
+            samples.push_back(std::chrono::duration<double, std::nano>(end - start).count() / benchmark.operations);
+        }
+    }
+
+    BenchmarkResult result;
+    result.name = benchmark.name;
+    result.operations = benchmark.operations;
+
+    double total = 0.0;
+    for (double sample : samples)
+    {
+        total += sample;
+    }
+    result.meanNs = total / samples.size();
+
+    double variance = 0.0;
+    for (double sample : samples)
+    {
+        variance += (sample - result.meanNs) * (sample - result.meanNs);
+    }
+    result.stddevNs = samples.size() > 1 ? std::sqrt(variance / (samples.size() - 1)) : 0.0;
+
+    std::sort(samples.begin(), samples.end());
+    size_t middle = samples.size() / 2;
+    result.medianNs = samples.size() % 2 == 1 ? samples[middle] : (samples[middle - 1] + samples[middle]) / 2.0;
+    result.minNs = samples.front();
+    result.maxNs = samples.back();
+    return result;
+}
+
+// Writes a level sized CSV like the ones in resources/worlds
+static std::string WriteDataMatrix(int width, int height)
+{
+    auto path = std::filesystem::temp_directory_path() / ("microbench_" + std::to_string(width) + "x" + std::to_string(height) + ".csv");
+    std::ofstream file(path);
+    std::mt19937 random(1);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            file << GetRandomInt(random, 0, 3) << (x + 1 < width ? "," : "");
+        }
+        file << "\n";
+    }
+    return path.string();
+}
+
+// World whose ground has a block every `spacing` tiles
+static World *MakeBlockWorld(int size, int spacing)
+{
+    LevelMatrix ground(size, std::pmr::vector<int>(size, 0));
+    LevelMatrix entities(size, std::pmr::vector<int>(size, 0));
+    for (int y = 0; y < size; y += spacing)
+    {
+        for (int x = 0; x < size; x += spacing)
+        {
+            ground[y][x] = 3;
+        }
+    }
+    World *world = CreateWorld(1, ground, entities);
+    SeedWorld(world, 1);
+    return world;
+}
+
+static std::vector<Benchmark> MakeBenchmarks()
+{
+    std::vector<Benchmark> benchmarks;
+
+    // Level loading
+    for (int size : {256, 1024})
+    {
+        std::string path = WriteDataMatrix(size, size);
+        benchmarks.push_back({"LoadDataMatrix/" + std::to_string(size) + "x" + std::to_string(size), 1, nullptr, [path]() {
+                                  int width = 0;
+                                  int height = 0;
+                                  auto matrix = LoadDataMatrix(path, width, height);
+                                  KeepAlive(matrix.data());
+                              }});
+    }
+
+    // Restarting a level: building the world again against restoring the snapshot taken at load
+    static World *restartWorld = nullptr;
+    static WorldSnapshot restartSnapshot;
+    for (int size : {256, 1024})
+    {
+        std::string suffix = std::to_string(size) + "x" + std::to_string(size);
+        benchmarks.push_back({"Restart/rebuild " + suffix, 1, nullptr, [size]() {
+                                  World *world = MakeBlockWorld(size, 8);
+                                  KeepAlive(world->width);
+                                  DeleteWorld(world);
+                              }});
+        benchmarks.push_back({"Restart/restore " + suffix, 1, [size]() {
+                                  DeleteWorld(restartWorld);
+                                  restartWorld = MakeBlockWorld(size, 8);
+                                  SaveWorld(restartWorld, restartSnapshot);
+                              },
+                              []() {
+                                  KeepAlive(RestoreWorld(restartWorld, restartSnapshot));
+                              }});
+    }
+
+    // Rich text markup, every call misses the cache when cycling through more strings than it holds
+    static std::vector<std::string> richTexts;
+    richTexts.clear();
+    for (int i = 0; i < RICH_TEXT_CACHE_SIZE * 2; i++)
+    {
+        richTexts.push_back("Press <color=0,255,155,255> [" + std::to_string(i) + "] </color> to start, <color=150,0,0,255>[M]</color> Main Menu");
+    }
+    benchmarks.push_back({"RichText/parse", static_cast<int>(richTexts.size()), RichText::Clear, []() {
+                              for (const auto &text : richTexts)
+                              {
+                                  KeepAlive(RichText::GetLayout(text.c_str(), 20, WHITE).width);
+                              }
+                          }});
+    benchmarks.push_back({"RichText/cached", 10000, nullptr, []() {
+                              for (int i = 0; i < 10000; i++)
+                              {
+                                  KeepAlive(RichText::GetLayout(richTexts[0].c_str(), 20, WHITE).width);
+                              }
+                          }});
+
+    // Random helpers, on the shared generator and on a seeded one
+    benchmarks.push_back({"GetRandomFloat", 100000, nullptr, []() {
+                              for (int i = 0; i < 100000; i++)
+                              {
+                                  KeepAlive(GetRandomFloat(0.0f, 1.0f));
+                              }
+                          }});
+    benchmarks.push_back({"GetRandomInt", 100000, nullptr, []() {
+                              for (int i = 0; i < 100000; i++)
+                              {
+                                  KeepAlive(GetRandomInt(0, 100));
+                              }
+                          }});
+    benchmarks.push_back({"GetRandomVector", 100000, nullptr, []() {
+                              for (int i = 0; i < 100000; i++)
+                              {
+                                  KeepAlive(GetRandomVector(0.0f, 0.0f, 100.0f, 100.0f));
+                              }
+                          }});
+    benchmarks.push_back({"GetRandomFloat/seeded", 100000, nullptr, []() {
+                              static std::mt19937 random(1);
+                              for (int i = 0; i < 100000; i++)
+                              {
+                                  KeepAlive(GetRandomFloat(random, 0.0f, 1.0f));
+                              }
+                          }});
+
+    // Particles, with lifetimes spread so some die in every update
+    static ParticleSystem *particles = nullptr;
+    for (int count : {1000, 10000, 100000})
+    {
+        benchmarks.push_back({"ParticleSystem::Update/" + std::to_string(count), 10, [count]() {
+                                  delete particles;
+                                  particles = new ParticleSystem();
+                                  particles->SetBudget(count);
+                                  std::mt19937 random(1);
+                                  for (int i = 0; i < count; i++)
+                                  {
+                                      particles->Emit(GetRandomVector(random, 0, 0, 1000, 1000),
+                                                      GetRandomVector(random, -50, -50, 50, 50),
+                                                      GetRandomFloat(random, 1.0f, 4.0f), WHITE,
+                                                      GetRandomFloat(random, 0.5f, 3.0f));
+                                  }
+                              },
+                              []() {
+                                  for (int i = 0; i < 10; i++)
+                                  {
+                                      particles->Update(1.0f / 60.0f);
+                                  }
+                                  KeepAlive(particles->GetCount());
+                              }});
+    }
+
+    // Fades, full pools of rects that can't be merged
+    benchmarks.push_back({"FXManager::Update/" + std::to_string(MAX_FADE_RECTS * 2), 60, []() {
+                              FXManager::Cleanup();
+                              std::mt19937 random(1);
+                              for (int i = 0; i < MAX_FADE_RECTS; i++)
+                              {
+                                  Rectangle rect = {0, i * TILE_SIZE, TILE_SIZE, TILE_SIZE};
+                                  FXManager::AddFadeRect(rect, WHITE, GetRandomFloat(random, 0.5f, 2.0f), true);
+                                  FXManager::AddFadeRect(rect, RED, GetRandomFloat(random, 0.5f, 2.0f), false);
+                              }
+                          },
+                          []() {
+                              for (int i = 0; i < 60; i++)
+                              {
+                                  FXManager::Update(1.0f / 60.0f);
+                              }
+                          }});
+
+    // Timers spread over a second, all of them run during the timed updates
+    static int tasksRun = 0;
+    for (int count : {1000, 10000})
+    {
+        benchmarks.push_back({"Scheduler::Update/" + std::to_string(count) + " tasks", count, [count]() {
+                                  Scheduler::Clear();
+                                  Scheduler::Reserve(count);
+                                  for (int i = 0; i < count; i++)
+                                  {
+                                      Scheduler::SetTimeout([]() { tasksRun++; }, (i % 60) / 60.0f);
+                                  }
+                              },
+                              []() {
+                                  for (int i = 0; i < 61; i++)
+                                  {
+                                      Scheduler::Update(1.0f / 60.0f);
+                                  }
+                                  KeepAlive(tasksRun);
+                              }});
+    }
+
+    // Player collisions against worlds with more and more blocks
+    static World *blockWorld = nullptr;
+    static std::vector<Vector2> probes;
+    for (int spacing : {8, 2})
+    {
+        benchmarks.push_back({"IsCollidingWithBlocks/" + std::to_string((128 / spacing) * (128 / spacing)) + " blocks", 1000, [spacing]() {
+                                  if (blockWorld != nullptr)
+                                  {
+                                      DeleteWorld(blockWorld);
+                                  }
+                                  blockWorld = MakeBlockWorld(128, spacing);
+                                  std::mt19937 random(1);
+                                  probes.clear();
+                                  for (int i = 0; i < 1000; i++)
+                                  {
+                                      probes.push_back(GetRandomVector(random, 0, 0, 128 * TILE_SIZE, 128 * TILE_SIZE));
+                                  }
+                              },
+                              []() {
+                                  int hits = 0;
+                                  for (auto probe : probes)
+                                  {
+                                      hits += IsCollidingWithBlocks(blockWorld, probe);
+                                  }
+                                  KeepAlive(hits);
+                              }});
+    }
+
+    // Sound requests, the queue is drained between repetitions. No sound is loaded,
+    // so only the request side is measured
+    benchmarks.push_back({"SoundManager::PlaySound", 128, SoundManager::ProcessAudio, []() {
+                              for (int i = 0; i < 128; i++)
+                              {
+                                  SoundManager::PlaySound(static_cast<SoundId>(i % static_cast<int>(SoundId::Count)), 0.3f, 0.1f);
+                              }
+                          }});
+    benchmarks.push_back({"SoundManager::QueueSound+Flush", 1000, SoundManager::ProcessAudio, []() {
+                              for (int i = 0; i < 1000; i++)
+                              {
+                                  SoundManager::QueueSound(i % 2 == 0 ? SFX_GRASS : SFX_DRY, 0.3f, 0.1f, Vector2{i * 1.0f, 0});
+                              }
+                              SoundManager::Flush();
+                          }});
+
+    return benchmarks;
+}
+
+static void WriteJson(const char *path, const std::vector<BenchmarkResult> &results, int warmup, int repetitions)
+{
+    FILE *file = fopen(path, "w");
+    if (file == nullptr)
+    {
+        std::cerr << "Unable to write " << path << std::endl;
+        return;
+    }
+    fprintf(file, "{\n  \"warmup\": %d,\n  \"repetitions\": %d,\n  \"benchmarks\": [\n", warmup, repetitions);
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const auto &result = results[i];
+        fprintf(file,
+                "    {\"name\": \"%s\", \"operations\": %d, \"median_ns\": %.3f, \"mean_ns\": %.3f, "
+                "\"stddev_ns\": %.3f, \"min_ns\": %.3f, \"max_ns\": %.3f}%s\n",
+                result.name.c_str(), result.operations, result.medianNs, result.meanNs,
+                result.stddevNs, result.minNs, result.maxNs, i + 1 == results.size() ? "" : ",");
+    }
+    fprintf(file, "  ]\n}\n");
+    fclose(file);
+}
+
+int main(int argc, char **argv)
+{
+    int repetitions = 15;
+    int warmup = 3;
+    const char *filter = nullptr;
+    const char *outPath = nullptr;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc)
+            repetitions = std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+            warmup = std::max(0, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+            filter = argv[++i];
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+            outPath = argv[++i];
+        else
+        {
+            std::cerr << "Unknown argument " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    SetTraceLogLevel(LOG_WARNING);
+
+    std::vector<BenchmarkResult> results;
+    printf("%-36s %14s %14s %8s %14s\n", "Benchmark", "median ns/op", "mean ns/op", "spread", "min ns/op");
+    for (const auto &benchmark : MakeBenchmarks())
+    {
+        if (filter != nullptr && benchmark.name.find(filter) == std::string::npos)
+        {
+            continue;
+        }
+        auto result = Measure(benchmark, warmup, repetitions);
+        double spread = result.meanNs > 0.0 ? result.stddevNs / result.meanNs * 100.0 : 0.0;
+        printf("%-36s %14.2f %14.2f %7.1f%% %14.2f\n", result.name.c_str(), result.medianNs, result.meanNs, spread, result.minNs);
+        fflush(stdout);
+        results.push_back(result);
+    }
+
+    if (outPath != nullptr)
+    {
+        WriteJson(outPath, results, warmup, repetitions);
+    }
+    return 0;
+}
@@ -0,0 +1,15 @@
+#version 330 core
+
+in vec2 fragTexCoord;
+in vec4 fragColor;
+out vec4 finalColor;
+
+void main() {
+    // Each particle is a quad with texcoords in [0,1], turn it into a disc
+    vec2 centered = fragTexCoord * 2.0 - 1.0;
+    float distance = dot(centered, centered);
+    if (distance > 1.0) discard;
+
+    float falloff = 1.0 - smoothstep(0.8, 1.0, distance);
+    finalColor = vec4(fragColor.rgb, fragColor.a * falloff);
+}
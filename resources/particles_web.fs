@@ -0,0 +1,14 @@
+precision mediump float;
+
+varying vec2 fragTexCoord;
+varying vec4 fragColor;
+
+void main() {
+    // Each particle is a quad with texcoords in [0,1], turn it into a disc
+    vec2 centered = fragTexCoord * 2.0 - 1.0;
+    float distance = dot(centered, centered);
+    if (distance > 1.0) discard;
+
+    float falloff = 1.0 - smoothstep(0.8, 1.0, distance);
+    gl_FragColor = vec4(fragColor.rgb, fragColor.a * falloff);
+}
@@ -0,0 +1,156 @@
+#include "AllocTracker.h"
+
+#if defined(ENABLE_ALLOC_TRACKING)
+
+#include <cstdlib>
+#include <new>
+#include "raylib.h"
+
+// Every block starts with a header holding its size, so delete knows how much is freed.
+// Kept at 16 bytes so the memory after it has the alignment malloc gives
+inline constexpr size_t ALLOC_HEADER_SIZE = 16;
+
+// Plain counters, no destructor, so they can be touched while the thread starts or exits
+static thread_local AllocStats threadTotal;
+
+void AllocTracker::OnAllocate(size_t size)
+{
+    totalAllocations.fetch_add(1, std::memory_order_relaxed);
+    totalBytes.fetch_add(size, std::memory_order_relaxed);
+    threadTotal.allocations++;
+    threadTotal.bytes += size;
+
+    int64_t live = liveBytes.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed) + static_cast<int64_t>(size);
+    int64_t peak = peakLiveBytes.load(std::memory_order_relaxed);
+    while (live > peak && !peakLiveBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+    {
+    }
+}
+
+void AllocTracker::OnFree(size_t size)
+{
+    liveBytes.fetch_sub(static_cast<int64_t>(size), std::memory_order_relaxed);
+}
+
+AllocStats AllocTracker::GetTotal()
+{
+    return {totalAllocations.load(std::memory_order_relaxed), totalBytes.load(std::memory_order_relaxed)};
+}
+
+AllocStats AllocTracker::GetThreadTotal()
+{
+    return threadTotal;
+}
+
+void AllocTracker::EndFrame()
+{
+    AllocStats total = GetTotal();
+    lastFrame = {total.allocations - frameStart.allocations, total.bytes - frameStart.bytes};
+    frameStart = total;
+
+    if (lastFrame.allocations > maxFrame.allocations)
+    {
+        maxFrame = lastFrame;
+    }
+    if (lastFrame.allocations > frameBudget)
+    {
+        // Only the first ones are logged, a frame over budget tends to come with many more
+        budgetViolations++;
+        if (budgetViolations <= 10)
+        {
+            TraceLog(LOG_WARNING, "ALLOC: Frame over budget, %llu allocations (%llu bytes) for a budget of %llu",
+                     static_cast<unsigned long long>(lastFrame.allocations), static_cast<unsigned long long>(lastFrame.bytes),
+                     static_cast<unsigned long long>(frameBudget));
+        }
+    }
+}
+
+void AllocTracker::PrintSummary()
+{
+    AllocStats total = GetTotal();
+    TraceLog(LOG_INFO, "ALLOC: %llu allocations, %llu bytes in total, peak of %lld bytes live",
+             static_cast<unsigned long long>(total.allocations), static_cast<unsigned long long>(total.bytes),
+             static_cast<long long>(GetPeakLiveBytes()));
+    TraceLog(LOG_INFO, "ALLOC: At most %llu allocations (%llu bytes) in a frame, %llu frames over budget",
+             static_cast<unsigned long long>(maxFrame.allocations), static_cast<unsigned long long>(maxFrame.bytes),
+             static_cast<unsigned long long>(budgetViolations));
+}
+
+// Replacements of the global allocation functions, the header is as big as the alignment
+// asked for so the block after it stays aligned
+
+static void *Allocate(size_t size, size_t alignment)
+{
+    size_t header = alignment > ALLOC_HEADER_SIZE ? alignment : ALLOC_HEADER_SIZE;
+    size_t total = header + (size > 0 ? size : 1);
+    void *block;
+    if (alignment > ALLOC_HEADER_SIZE)
+    {
+        // aligned_alloc wants a multiple of the alignment
+        block = std::aligned_alloc(alignment, (total + alignment - 1) & ~(alignment - 1));
+    }
+    else
+    {
+        block = std::malloc(total);
+    }
+    if (block == nullptr)
+    {
+        return nullptr;
+    }
+
+    char *memory = static_cast<char *>(block) + header;
+    reinterpret_cast<size_t *>(memory)[-1] = size;
+    AllocTracker::OnAllocate(size);
+    return memory;
+}
+
+static void Free(void *memory, size_t alignment)
+{
+    if (memory == nullptr)
+    {
+        return;
+    }
+    size_t header = alignment > ALLOC_HEADER_SIZE ? alignment : ALLOC_HEADER_SIZE;
+    AllocTracker::OnFree(reinterpret_cast<size_t *>(memory)[-1]);
+    std::free(static_cast<char *>(memory) - header);
+}
+
+static void *AllocateOrThrow(size_t size, size_t alignment)
+{
+    void *memory = Allocate(size, alignment);
+    while (memory == nullptr)
+    {
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        handler();
+        memory = Allocate(size, alignment);
+    }
+    return memory;
+}
+
+void *operator new(size_t size) { return AllocateOrThrow(size, 0); }
+void *operator new[](size_t size) { return AllocateOrThrow(size, 0); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept { return Allocate(size, 0); }
+void *operator new[](size_t size, const std::nothrow_t &) noexcept { return Allocate(size, 0); }
+void *operator new(size_t size, std::align_val_t alignment) { return AllocateOrThrow(size, static_cast<size_t>(alignment)); }
+void *operator new[](size_t size, std::align_val_t alignment) { return AllocateOrThrow(size, static_cast<size_t>(alignment)); }
+void *operator new(size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept { return Allocate(size, static_cast<size_t>(alignment)); }
+void *operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept { return Allocate(size, static_cast<size_t>(alignment)); }
+
+void operator delete(void *memory) noexcept { Free(memory, 0); }
+void operator delete[](void *memory) noexcept { Free(memory, 0); }
+void operator delete(void *memory, size_t) noexcept { Free(memory, 0); }
+void operator delete[](void *memory, size_t) noexcept { Free(memory, 0); }
+void operator delete(void *memory, const std::nothrow_t &) noexcept { Free(memory, 0); }
+void operator delete[](void *memory, const std::nothrow_t &) noexcept { Free(memory, 0); }
+void operator delete(void *memory, std::align_val_t alignment) noexcept { Free(memory, static_cast<size_t>(alignment)); }
+void operator delete[](void *memory, std::align_val_t alignment) noexcept { Free(memory, static_cast<size_t>(alignment)); }
+void operator delete(void *memory, size_t, std::align_val_t alignment) noexcept { Free(memory, static_cast<size_t>(alignment)); }
+void operator delete[](void *memory, size_t, std::align_val_t alignment) noexcept { Free(memory, static_cast<size_t>(alignment)); }
+void operator delete(void *memory, std::align_val_t alignment, const std::nothrow_t &) noexcept { Free(memory, static_cast<size_t>(alignment)); }
+void operator delete[](void *memory, std::align_val_t alignment, const std::nothrow_t &) noexcept { Free(memory, static_cast<size_t>(alignment)); }
+
+#endif // ENABLE_ALLOC_TRACKING
@@ -0,0 +1,73 @@
+#ifndef ALLOC_TRACKER_H
+#define ALLOC_TRACKER_H
+
+// Counts every C++ heap allocation (operator new) by replacing the global allocation functions.
+// Only compiled in when ENABLE_ALLOC_TRACKING is defined (make ALLOC_TRACKING=1), otherwise
+// the macros expand to nothing and the default allocator is used.
+//
+//   ALLOC_END_FRAME();           // once per frame, after PROFILE_FRAME
+//   ALLOC_FRAME_BUDGET(count);   // warns about frames with more allocations than that
+//   ALLOC_SUMMARY();             // logs the high-water marks, at shutdown
+//
+// With the profiler compiled in as well, every zone shows the allocations made inside it.
+// bench_world --alloc-budget N fails the run when a simulation step allocates more than N times.
+
+#if defined(ENABLE_ALLOC_TRACKING)
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+struct AllocStats
+{
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+};
+
+class AllocTracker
+{
+private:
+    inline static std::atomic<uint64_t> totalAllocations{0};
+    inline static std::atomic<uint64_t> totalBytes{0};
+    inline static std::atomic<int64_t> liveBytes{0};
+    inline static std::atomic<int64_t> peakLiveBytes{0};
+
+    // Frames are counted over every thread, only touched by the main thread
+    inline static AllocStats frameStart;
+    inline static AllocStats lastFrame;
+    inline static AllocStats maxFrame;
+    inline static uint64_t frameBudget = UINT64_MAX;
+    inline static uint64_t budgetViolations = 0;
+
+public:
+    static void OnAllocate(size_t size);
+    static void OnFree(size_t size);
+
+    // Process wide totals since the start
+    static AllocStats GetTotal();
+    // Totals of the calling thread, the difference between two calls is what the thread allocated
+    static AllocStats GetThreadTotal();
+    static int64_t GetLiveBytes() { return liveBytes.load(std::memory_order_relaxed); }
+    static int64_t GetPeakLiveBytes() { return peakLiveBytes.load(std::memory_order_relaxed); }
+
+    static void EndFrame();
+    static AllocStats GetLastFrame() { return lastFrame; }
+    static AllocStats GetMaxFrame() { return maxFrame; }
+    static void SetFrameBudget(uint64_t allocations) { frameBudget = allocations; }
+    static uint64_t GetBudgetViolations() { return budgetViolations; }
+    static void PrintSummary();
+};
+
+#define ALLOC_END_FRAME() AllocTracker::EndFrame()
+#define ALLOC_FRAME_BUDGET(count) AllocTracker::SetFrameBudget(count)
+#define ALLOC_SUMMARY() AllocTracker::PrintSummary()
+
+#else
+
+#define ALLOC_END_FRAME()
+#define ALLOC_FRAME_BUDGET(count)
+#define ALLOC_SUMMARY()
+
+#endif // ENABLE_ALLOC_TRACKING
+
+#endif // ALLOC_TRACKER_H
@@ -0,0 +1,141 @@
+#include "Arena.h"
+#include <algorithm>
+#include <mutex>
+#include <new>
+#include "Counters.h"
+
+struct ArenaBlock
+{
+    char *memory = nullptr;
+    size_t size = 0;
+};
+
+// Blocks of the arenas destroyed last, arenas are created and destroyed from several threads
+static std::mutex blockMutex;
+static ArenaBlock cachedBlocks[ARENA_CACHED_BLOCKS];
+
+// Smallest cached block that fits, or a new one. capacity is set to the size of the block
+static char *AcquireBlock(size_t &capacity)
+{
+    capacity = (std::max(capacity, ARENA_ALIGNMENT) + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+    {
+        std::lock_guard<std::mutex> lock(blockMutex);
+        ArenaBlock *best = nullptr;
+        for (auto &cached : cachedBlocks)
+        {
+            if (cached.memory != nullptr && cached.size >= capacity && (best == nullptr || cached.size < best->size))
+            {
+                best = &cached;
+            }
+        }
+        if (best != nullptr)
+        {
+            char *memory = best->memory;
+            capacity = best->size;
+            *best = {};
+            return memory;
+        }
+    }
+    return static_cast<char *>(::operator new(capacity, std::align_val_t(ARENA_ALIGNMENT)));
+}
+
+// Keeps the block for the next arena, in place of a smaller one when the cache is full
+static void ReleaseBlock(char *memory, size_t size)
+{
+    if (memory == nullptr)
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(blockMutex);
+        ArenaBlock *smallest = &cachedBlocks[0];
+        for (auto &cached : cachedBlocks)
+        {
+            if (cached.size < smallest->size)
+            {
+                smallest = &cached;
+            }
+        }
+        if (smallest->size < size)
+        {
+            std::swap(smallest->memory, memory);
+            std::swap(smallest->size, size);
+        }
+    }
+    if (memory != nullptr)
+    {
+        ::operator delete(memory, std::align_val_t(ARENA_ALIGNMENT));
+    }
+}
+
+Arena::Arena(size_t capacity, size_t maxCapacity) : capacity(capacity), maxCapacity(std::max(capacity, maxCapacity))
+{
+    block = AcquireBlock(this->capacity);
+}
+
+Arena::~Arena()
+{
+    ReleaseBlock(block, capacity);
+}
+
+void *Arena::do_allocate(size_t bytes, size_t alignment)
+{
+    size_t offset = (used + alignment - 1) & ~(alignment - 1);
+    if (alignment <= ARENA_ALIGNMENT && offset + bytes <= capacity)
+    {
+        used = offset + bytes;
+        highWater = std::max(highWater, used + overflowBytes);
+        return block + offset;
+    }
+
+    overflowBytes += bytes + alignment;
+    highWater = std::max(highWater, used + overflowBytes);
+    return overflow.allocate(bytes, alignment);
+}
+
+void Arena::Reset()
+{
+    overflow.release();
+    if (overflowBytes > 0 && capacity < maxCapacity)
+    {
+        // Everything used at once fits in the next block, unless it's over the limit
+        ReleaseBlock(block, capacity);
+        capacity = std::min(highWater, maxCapacity);
+        block = AcquireBlock(capacity);
+    }
+    used = 0;
+    overflowBytes = 0;
+}
+
+void FrameArena::Init(size_t capacity, size_t maxCapacity)
+{
+    if (arena == nullptr)
+    {
+        arena = new Arena(capacity, maxCapacity);
+        owner = std::this_thread::get_id();
+    }
+}
+
+void FrameArena::Reset()
+{
+    if (arena != nullptr)
+    {
+        COUNTER_SET(Counter::FrameArenaBytes, arena->GetUsed());
+        arena->Reset();
+    }
+}
+
+void FrameArena::Shutdown()
+{
+    delete arena;
+    arena = nullptr;
+}
+
+std::pmr::memory_resource *FrameArena::Get()
+{
+    if (arena != nullptr && std::this_thread::get_id() == owner)
+    {
+        return arena;
+    }
+    return std::pmr::get_default_resource();
+}
@@ -0,0 +1,65 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <thread>
+
+inline constexpr size_t ARENA_ALIGNMENT = 64;
+inline constexpr int ARENA_CACHED_BLOCKS = 2;
+inline constexpr size_t FRAME_ARENA_SIZE = 256 * 1024;
+// The frame block grows at most to this, bigger one-off temporaries stay on the heap
+inline constexpr size_t FRAME_ARENA_MAX_SIZE = 4 * FRAME_ARENA_SIZE;
+
+// Bump allocator over a single block, for memory that all goes away at the same time.
+// Deallocating does nothing, Reset (or the destructor) gives everything back at once.
+// What doesn't fit in the block comes from the heap until the next Reset, which then grows
+// the block to the most that was used (up to maxCapacity) so it fits from then on.
+// Released blocks are kept for the next arena, so loading a level again doesn't allocate.
+class Arena : public std::pmr::memory_resource
+{
+private:
+    char *block = nullptr;
+    size_t capacity = 0;
+    size_t maxCapacity = SIZE_MAX;
+    size_t used = 0;
+    size_t overflowBytes = 0;
+    size_t highWater = 0;
+    std::pmr::monotonic_buffer_resource overflow{std::pmr::new_delete_resource()};
+
+protected:
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *memory, size_t bytes, size_t alignment) override {}
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+
+public:
+    explicit Arena(size_t capacity, size_t maxCapacity = SIZE_MAX);
+    ~Arena();
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    void Reset();
+    // Bytes given out since the last Reset, the heap ones included
+    size_t GetUsed() const { return used + overflowBytes; }
+    size_t GetCapacity() const { return capacity; }
+    size_t GetHighWater() const { return highWater; }
+};
+
+// Arena of the main thread reset at the start of every frame, for data that doesn't outlive
+// the frame. Get returns the heap on any other thread (or before Init), so code that also
+// runs on the loader threads can use it as is
+class FrameArena
+{
+private:
+    inline static Arena *arena = nullptr;
+    inline static std::thread::id owner;
+
+public:
+    static void Init(size_t capacity = FRAME_ARENA_SIZE, size_t maxCapacity = FRAME_ARENA_MAX_SIZE);
+    static void Reset();
+    static void Shutdown();
+    static std::pmr::memory_resource *Get();
+};
+
+#endif // ARENA_H
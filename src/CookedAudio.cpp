@@ -0,0 +1,224 @@
+#include "CookedAudio.h"
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+
+#if !defined(PLATFORM_WEB)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+std::string GetCookedAudioPath(const char *sourcePath)
+{
+    std::string path = sourcePath;
+    size_t slash = path.find_last_of('/');
+    std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+    size_t dot = name.find_last_of('.');
+    if (dot != std::string::npos)
+    {
+        name = name.substr(0, dot);
+    }
+    return COOKED_AUDIO_DIR + name + ".pcm";
+}
+
+bool SaveCookedAudio(const char *path, const Wave &wave)
+{
+    FILE *file = fopen(path, "wb");
+    if (!file)
+    {
+        std::cerr << "Unable to write cooked audio: " << path << std::endl;
+        return false;
+    }
+
+    CookedAudioHeader header{};
+    memcpy(header.magic, COOKED_AUDIO_MAGIC, sizeof(header.magic));
+    header.version = COOKED_AUDIO_VERSION;
+    header.sampleRate = wave.sampleRate;
+    header.sampleSize = static_cast<uint16_t>(wave.sampleSize);
+    header.channels = static_cast<uint16_t>(wave.channels);
+    header.frameCount = wave.frameCount;
+
+    size_t dataSize = static_cast<size_t>(wave.frameCount) * wave.channels * (wave.sampleSize / 8);
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(wave.data, 1, dataSize, file) == dataSize;
+    fclose(file);
+    return ok;
+}
+
+static bool ReadCookedFile(const char *path, CookedAudio &audio, bool resident)
+{
+#if !defined(PLATFORM_WEB)
+    if (!resident)
+    {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(CookedAudioHeader)))
+        {
+            close(fd);
+            return false;
+        }
+
+        void *memory = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (memory == MAP_FAILED)
+        {
+            return false;
+        }
+        madvise(memory, info.st_size, MADV_SEQUENTIAL);
+
+        audio.memory = memory;
+        audio.memorySize = info.st_size;
+        audio.mapped = true;
+        return true;
+    }
+#endif
+
+    int size = 0;
+    unsigned char *data = LoadFileData(path, &size);
+    if (!data)
+    {
+        return false;
+    }
+    audio.memory = data;
+    audio.memorySize = size;
+    audio.mapped = false;
+    return true;
+}
+
+bool LoadCookedAudio(const char *path, CookedAudio &audio, bool resident)
+{
+    if (!FileExists(path) || !ReadCookedFile(path, audio, resident))
+    {
+        return false;
+    }
+
+    // A truncated file (an interrupted make cook) may not even hold the header
+    if (audio.memorySize < sizeof(CookedAudioHeader))
+    {
+        std::cerr << "Invalid cooked audio: " << path << std::endl;
+        UnloadCookedAudio(audio);
+        return false;
+    }
+
+    const auto *header = static_cast<const CookedAudioHeader *>(audio.memory);
+    // Compared by division, the product can overflow a 32-bit size_t on the web
+    size_t frameSize = static_cast<size_t>(header->channels) * (header->sampleSize / 8);
+    size_t available = audio.memorySize - sizeof(CookedAudioHeader);
+    if (memcmp(header->magic, COOKED_AUDIO_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != COOKED_AUDIO_VERSION ||
+        frameSize == 0 || header->frameCount > available / frameSize)
+    {
+        std::cerr << "Invalid cooked audio: " << path << std::endl;
+        UnloadCookedAudio(audio);
+        return false;
+    }
+
+    audio.wave.frameCount = header->frameCount;
+    audio.wave.sampleRate = header->sampleRate;
+    audio.wave.sampleSize = header->sampleSize;
+    audio.wave.channels = header->channels;
+    audio.wave.data = static_cast<unsigned char *>(audio.memory) + sizeof(CookedAudioHeader);
+    return true;
+}
+
+void UnloadCookedAudio(CookedAudio &audio)
+{
+    if (!audio.memory)
+    {
+        return;
+    }
+
+#if !defined(PLATFORM_WEB)
+    if (audio.mapped)
+    {
+        munmap(audio.memory, audio.memorySize);
+    }
+    else
+#endif
+    {
+        UnloadFileData(static_cast<unsigned char *>(audio.memory));
+    }
+    audio = CookedAudio{};
+}
+
+bool LoadCookedStream(const char *path, CookedStream &cooked)
+{
+    // Short loops are cheap enough to keep in memory, long tracks are read from the mapping
+    int fileSize = FileExists(path) ? GetFileLength(path) : 0;
+    bool resident = fileSize > 0 && static_cast<size_t>(fileSize) <= RESIDENT_AUDIO_MAX_BYTES;
+    if (!LoadCookedAudio(path, cooked.audio, resident))
+    {
+        return false;
+    }
+
+    const Wave &wave = cooked.audio.wave;
+    SetAudioStreamBufferSizeDefault(COOKED_STREAM_BUFFER_FRAMES);
+    cooked.stream = LoadAudioStream(wave.sampleRate, wave.sampleSize, wave.channels);
+    SetAudioStreamBufferSizeDefault(0);
+
+    cooked.cursor = 0;
+    cooked.ready = IsAudioStreamReady(cooked.stream);
+    if (!cooked.ready)
+    {
+        UnloadCookedAudio(cooked.audio);
+    }
+    return cooked.ready;
+}
+
+void UnloadCookedStream(CookedStream &cooked)
+{
+    if (!cooked.ready)
+    {
+        return;
+    }
+    UnloadAudioStream(cooked.stream);
+    UnloadCookedAudio(cooked.audio);
+    cooked = CookedStream{};
+}
+
+void PlayCookedStream(CookedStream &cooked)
+{
+    cooked.cursor = 0;
+    UpdateCookedStream(cooked);
+    PlayAudioStream(cooked.stream);
+}
+
+void StopCookedStream(CookedStream &cooked)
+{
+    StopAudioStream(cooked.stream);
+}
+
+void UpdateCookedStream(CookedStream &cooked)
+{
+    const Wave &wave = cooked.audio.wave;
+    const auto *samples = static_cast<const unsigned char *>(wave.data);
+    unsigned int frameSize = wave.channels * (wave.sampleSize / 8);
+
+    while (IsAudioStreamProcessed(cooked.stream))
+    {
+        if (cooked.cursor >= wave.frameCount)
+        {
+            if (!cooked.looping)
+            {
+                return;
+            }
+            cooked.cursor = 0;
+        }
+
+        unsigned int frames = wave.frameCount - cooked.cursor;
+        if (frames > COOKED_STREAM_BUFFER_FRAMES)
+        {
+            frames = COOKED_STREAM_BUFFER_FRAMES;
+        }
+        UpdateAudioStream(cooked.stream, samples + static_cast<size_t>(cooked.cursor) * frameSize, frames);
+        cooked.cursor += frames;
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef COOKED_AUDIO_H
+#define COOKED_AUDIO_H
+
+#include "raylib.h"
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// Cooked audio is raw PCM already converted to the sample rate of the device, so
+// loading it is just mapping the file and playing it costs no decoding at all.
+// The files are written by tools/cook_audio (make cook) into resources/cooked.
+
+inline constexpr char COOKED_AUDIO_MAGIC[4] = {'L', 'D', 'P', 'C'};
+inline constexpr uint32_t COOKED_AUDIO_VERSION = 1;
+inline constexpr auto COOKED_AUDIO_DIR = "resources/cooked/";
+
+// Streams smaller than this are copied to memory instead of being read from the mapping
+inline constexpr size_t RESIDENT_AUDIO_MAX_BYTES = 4 * 1024 * 1024;
+inline constexpr unsigned int COOKED_STREAM_BUFFER_FRAMES = 4096;
+
+struct CookedAudioHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t sampleRate;
+    uint16_t sampleSize;
+    uint16_t channels;
+    uint32_t frameCount;
+    uint32_t reserved;
+};
+
+struct CookedAudio
+{
+    Wave wave{};
+    void *memory = nullptr;
+    size_t memorySize = 0;
+    bool mapped = false;
+};
+
+struct CookedStream
+{
+    CookedAudio audio;
+    AudioStream stream{};
+    unsigned int cursor = 0;
+    bool looping = true;
+    bool ready = false;
+};
+
+// resources/dry.wav -> resources/cooked/dry.pcm
+std::string GetCookedAudioPath(const char *sourcePath);
+
+bool SaveCookedAudio(const char *path, const Wave &wave);
+bool LoadCookedAudio(const char *path, CookedAudio &audio, bool resident);
+void UnloadCookedAudio(CookedAudio &audio);
+
+bool LoadCookedStream(const char *path, CookedStream &cooked);
+void UnloadCookedStream(CookedStream &cooked);
+void PlayCookedStream(CookedStream &cooked);
+void StopCookedStream(CookedStream &cooked);
+void UpdateCookedStream(CookedStream &cooked);
+
+#endif // COOKED_AUDIO_H
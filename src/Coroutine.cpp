@@ -0,0 +1,155 @@
+#include "Coroutine.h"
+#include <new>
+
+// Frames are rounded up to a power of two between 64 bytes and 4 KB, bigger ones use the heap
+inline constexpr size_t MIN_FRAME_SIZE_LOG2 = 6;
+inline constexpr size_t MAX_FRAME_SIZE_LOG2 = 12;
+inline constexpr size_t NUM_FRAME_SIZE_CLASSES = MAX_FRAME_SIZE_LOG2 - MIN_FRAME_SIZE_LOG2 + 1;
+
+struct FreeFrame {
+    FreeFrame *next;
+};
+
+static FreeFrame *freeFrames[NUM_FRAME_SIZE_CLASSES] = {};
+
+static int GetSizeClass(size_t size)
+{
+    for (size_t sizeClass = 0; sizeClass < NUM_FRAME_SIZE_CLASSES; sizeClass++)
+    {
+        if (size <= (size_t(1) << (sizeClass + MIN_FRAME_SIZE_LOG2)))
+        {
+            return static_cast<int>(sizeClass);
+        }
+    }
+    return -1;
+}
+
+void *CoroutineFramePool::Allocate(size_t size)
+{
+    int sizeClass = GetSizeClass(size);
+    if (sizeClass < 0)
+    {
+        return ::operator new(size);
+    }
+
+    if (FreeFrame *frame = freeFrames[sizeClass])
+    {
+        freeFrames[sizeClass] = frame->next;
+        return frame;
+    }
+    return ::operator new(size_t(1) << (sizeClass + MIN_FRAME_SIZE_LOG2));
+}
+
+void CoroutineFramePool::Free(void *frame, size_t size)
+{
+    int sizeClass = GetSizeClass(size);
+    if (sizeClass < 0)
+    {
+        ::operator delete(frame);
+        return;
+    }
+
+    auto freeFrame = static_cast<FreeFrame *>(frame);
+    freeFrame->next = freeFrames[sizeClass];
+    freeFrames[sizeClass] = freeFrame;
+}
+
+void CoroutineFramePool::Clear()
+{
+    for (auto &list : freeFrames)
+    {
+        while (list)
+        {
+            FreeFrame *next = list->next;
+            ::operator delete(list);
+            list = next;
+        }
+    }
+}
+
+Script::promise_type::~promise_type()
+{
+    if (slot != INVALID_TASK_INDEX)
+    {
+        Scripts::ReleaseSlot(slot);
+    }
+}
+
+void Scripts::Reserve(size_t count)
+{
+    slots.reserve(count);
+    freeSlots.reserve(count);
+}
+
+ScriptHandle Scripts::Start(Script script)
+{
+    uint32_t index;
+    if (!freeSlots.empty())
+    {
+        index = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else
+    {
+        index = static_cast<uint32_t>(slots.size());
+        slots.emplace_back();
+    }
+
+    auto &slot = slots[index];
+    slot.alive = true;
+    slot.stopRequested = false;
+    slot.pending = TaskHandle{};
+    ScriptHandle handle{index, slot.generation};
+
+    script.handle.promise().slot = index;
+    script.handle.resume();
+    return handle;
+}
+
+bool Scripts::IsRunning(ScriptHandle handle)
+{
+    return handle.index < slots.size() &&
+           slots[handle.index].alive &&
+           slots[handle.index].generation == handle.generation;
+}
+
+void Scripts::Stop(ScriptHandle handle)
+{
+    if (!IsRunning(handle))
+    {
+        return;
+    }
+
+    // Cancelling the pending task destroys the frame, which releases the slot. A script
+    // that is running right now (it stopped itself) is destroyed on its next suspension.
+    auto &slot = slots[handle.index];
+    if (!Scheduler::Cancel(slot.pending))
+    {
+        slot.stopRequested = true;
+    }
+}
+
+void Scripts::SetPending(ScriptCoroutine coroutine, TaskHandle task)
+{
+    uint32_t index = coroutine.promise().slot;
+    if (index >= slots.size())
+    {
+        return;
+    }
+
+    slots[index].pending = task;
+    if (slots[index].stopRequested)
+    {
+        Scheduler::Cancel(task);
+    }
+}
+
+void Scripts::ReleaseSlot(uint32_t index)
+{
+    auto &slot = slots[index];
+    slot.alive = false;
+    slot.stopRequested = false;
+    slot.pending = TaskHandle{};
+    slot.generation++;
+    freeSlots.push_back(index);
+}
@@ -0,0 +1,159 @@
+#ifndef COROUTINE_H
+#define COROUTINE_H
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <vector>
+#include "Scheduler.h"
+
+// Scripts are C++20 coroutines resumed by the Scheduler:
+//
+//     Script Blink(Entity *entity)
+//     {
+//         while (true)
+//         {
+//             entity->visible = !entity->visible;
+//             co_await Wait(0.5f);
+//         }
+//     }
+//
+//     ScriptHandle blink = Scripts::Start(Blink(entity));
+//     ...
+//     Scripts::Stop(blink);
+//
+// Frames come from a pool of size classes, so running scripts costs no heap traffic once warm.
+
+class CoroutineFramePool {
+public:
+    static void *Allocate(size_t size);
+    static void Free(void *frame, size_t size);
+    static void Clear();
+};
+
+struct ScriptHandle {
+    uint32_t index = INVALID_TASK_INDEX;
+    uint32_t generation = 0;
+};
+
+// Bookkeeping of a running script: the scheduler task that will resume it next
+struct ScriptSlot {
+    TaskHandle pending;
+    uint32_t generation = 0;
+    bool alive = false;
+    bool stopRequested = false;
+};
+
+class Scripts;
+
+struct Script {
+    struct promise_type {
+        uint32_t slot = INVALID_TASK_INDEX;
+
+        Script get_return_object() {
+            return Script{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+
+        ~promise_type();
+
+        static void *operator new(size_t size) { return CoroutineFramePool::Allocate(size); }
+        static void operator delete(void *frame, size_t size) { CoroutineFramePool::Free(frame, size); }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+using ScriptCoroutine = std::coroutine_handle<Script::promise_type>;
+
+// Scheduler task that resumes a suspended script. If the task is cancelled or
+// cleared before running, the script frame is destroyed with it.
+struct ResumeScript {
+    ScriptCoroutine coroutine;
+
+    explicit ResumeScript(ScriptCoroutine handle) : coroutine(handle) {}
+    ResumeScript(ResumeScript &&other) noexcept : coroutine(other.coroutine) { other.coroutine = nullptr; }
+    ResumeScript(const ResumeScript &) = delete;
+    ~ResumeScript() {
+        if (coroutine) {
+            coroutine.destroy();
+        }
+    }
+
+    void operator()() {
+        auto handle = coroutine;
+        coroutine = nullptr;
+        handle.resume();
+    }
+};
+
+class Scripts {
+private:
+    inline static std::vector<ScriptSlot> slots;
+    inline static std::vector<uint32_t> freeSlots;
+
+public:
+    static void Reserve(size_t count);
+
+    // Runs the script until its first suspension
+    static ScriptHandle Start(Script script);
+    static bool IsRunning(ScriptHandle handle);
+    static void Stop(ScriptHandle handle);
+
+    // Used by the awaitables to remember which task resumes the script
+    static void SetPending(ScriptCoroutine coroutine, TaskHandle task);
+    static void ReleaseSlot(uint32_t slot);
+};
+
+// co_await Wait(seconds)
+struct Wait {
+    float seconds;
+
+    explicit Wait(float delaySeconds) : seconds(delaySeconds) {}
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(ScriptCoroutine coroutine) {
+        Scripts::SetPending(coroutine, Scheduler::SetTimeout(ResumeScript(coroutine), seconds));
+    }
+    void await_resume() const noexcept {}
+};
+
+// co_await NextFrame()
+struct NextFrame : Wait {
+    NextFrame() : Wait(0.0f) {}
+};
+
+// co_await Until(predicate), the predicate is checked once per frame
+template <typename Predicate>
+struct Until {
+    Predicate predicate;
+
+    explicit Until(Predicate condition) : predicate(std::move(condition)) {}
+
+    // Checks the predicate without waking the script and only resumes it when it holds
+    struct Poll {
+        Until *awaiter;
+        ResumeScript resume;
+
+        void operator()() {
+            if (awaiter->predicate()) {
+                resume();
+                return;
+            }
+            Until *until = awaiter;
+            ScriptCoroutine coroutine = resume.coroutine;
+            Scripts::SetPending(coroutine, Scheduler::SetTimeout(Poll{until, std::move(resume)}, 0.0f));
+        }
+    };
+
+    bool await_ready() { return predicate(); }
+    void await_suspend(ScriptCoroutine coroutine) {
+        Scripts::SetPending(coroutine, Scheduler::SetTimeout(Poll{this, ResumeScript(coroutine)}, 0.0f));
+    }
+    void await_resume() const noexcept {}
+};
+
+#endif // COROUTINE_H
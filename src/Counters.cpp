@@ -0,0 +1,165 @@
+#include "Counters.h"
+
+#if defined(ENABLE_PROFILER)
+
+#include <cstddef>
+#include "raylib.h"
+
+#if !defined(PLATFORM_WEB)
+// raylib doesn't expose its batch internals, but on desktop it calls GL through the function
+// pointers loaded by its embedded glad, so they can be wrapped to count what reaches the driver
+extern "C"
+{
+    typedef void (*DrawElementsProc)(unsigned int mode, int count, unsigned int type, const void *indices);
+    typedef void (*DrawArraysProc)(unsigned int mode, int first, int count);
+    typedef void (*BufferSubDataProc)(unsigned int target, ptrdiff_t offset, ptrdiff_t size, const void *data);
+
+    extern DrawElementsProc glad_glDrawElements;
+    extern DrawArraysProc glad_glDrawArrays;
+    extern BufferSubDataProc glad_glBufferSubData;
+}
+
+static DrawElementsProc drawElements = nullptr;
+static DrawArraysProc drawArrays = nullptr;
+static BufferSubDataProc bufferSubData = nullptr;
+
+// A batch flush uploads its vertex buffers, then draws them. The first upload after a draw
+// starts the next flush
+static bool drawnSinceUpload = true;
+
+static void CountedDrawElements(unsigned int mode, int count, unsigned int type, const void *indices)
+{
+    COUNTER_ADD(Counter::DrawCalls, 1);
+    drawnSinceUpload = true;
+    drawElements(mode, count, type, indices);
+}
+
+static void CountedDrawArrays(unsigned int mode, int first, int count)
+{
+    COUNTER_ADD(Counter::DrawCalls, 1);
+    drawnSinceUpload = true;
+    drawArrays(mode, first, count);
+}
+
+static void CountedBufferSubData(unsigned int target, ptrdiff_t offset, ptrdiff_t size, const void *data)
+{
+    if (drawnSinceUpload)
+    {
+        drawnSinceUpload = false;
+        COUNTER_ADD(Counter::BatchFlushes, 1);
+    }
+    bufferSubData(target, offset, size, data);
+}
+#endif
+
+void Counters::HookDrawCalls()
+{
+#if !defined(PLATFORM_WEB)
+    // GL is only loaded once the window exists
+    if (!IsWindowReady() || glad_glDrawElements == nullptr)
+    {
+        return;
+    }
+    drawElements = glad_glDrawElements;
+    drawArrays = glad_glDrawArrays;
+    bufferSubData = glad_glBufferSubData;
+    glad_glDrawElements = CountedDrawElements;
+    glad_glDrawArrays = CountedDrawArrays;
+    glad_glBufferSubData = CountedBufferSubData;
+#endif
+    hooked = true;
+}
+
+void Counters::EndFrame()
+{
+    if (!hooked)
+    {
+        HookDrawCalls();
+    }
+
+    for (int i = 0; i < static_cast<int>(Counter::Count); i++)
+    {
+        lastFrame[i] = values[i].exchange(0, std::memory_order_relaxed);
+    }
+
+    if (csv != nullptr)
+    {
+        fprintf(csv, "%llu", (unsigned long long)frame);
+        for (auto value : lastFrame)
+        {
+            fprintf(csv, ",%lld", (long long)value);
+        }
+        fprintf(csv, "\n");
+    }
+    frame++;
+
+    if (IsKeyPressed(KEY_F6))
+    {
+        if (csv != nullptr)
+        {
+            StopDump();
+        }
+        else
+        {
+            StartDump(COUNTERS_CSV_PATH);
+        }
+    }
+}
+
+bool Counters::StartDump(const char *path)
+{
+    StopDump();
+    csv = fopen(path, "w");
+    if (csv == nullptr)
+    {
+        TraceLog(LOG_WARNING, "COUNTERS: Could not write %s", path);
+        return false;
+    }
+
+    fprintf(csv, "frame");
+    for (auto name : COUNTER_NAMES)
+    {
+        fprintf(csv, ",%s", name);
+    }
+    fprintf(csv, "\n");
+    TraceLog(LOG_INFO, "COUNTERS: Writing %s", path);
+    return true;
+}
+
+void Counters::StopDump()
+{
+    if (csv != nullptr)
+    {
+        fclose(csv);
+        csv = nullptr;
+        TraceLog(LOG_INFO, "COUNTERS: Dump stopped");
+    }
+}
+
+void Counters::DrawOverlay()
+{
+    if (IsKeyPressed(KEY_F5))
+    {
+        overlayVisible = !overlayVisible;
+    }
+    if (!overlayVisible)
+    {
+        return;
+    }
+
+    int x = GetScreenWidth() - 250;
+    int y = 50;
+    int count = static_cast<int>(Counter::Count);
+    DrawRectangle(x - 5, y - 5, 245, count * 12 + 24, Fade(BLACK, 0.75f));
+    DrawText(csv != nullptr ? "Counters (writing CSV)" : "Counters", x, y, 10, csv != nullptr ? RED : YELLOW);
+    y += 14;
+
+    for (int i = 0; i < count; i++)
+    {
+        DrawText(COUNTER_NAMES[i], x, y, 10, WHITE);
+        DrawText(TextFormat("%lld", (long long)lastFrame[i]), x + 160, y, 10, WHITE);
+        y += 12;
+    }
+}
+
+#endif // ENABLE_PROFILER
@@ -0,0 +1,112 @@
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+// Per-frame workload counters filled in by the engine. Compiled in together with the profiler
+// (make PROFILE=1), otherwise the macros expand to nothing.
+//
+//   COUNTER_ADD(Counter::TilesTouched, 1);       // adds to the current frame
+//   COUNTER_SET(Counter::ParticlesAlive, count);  // gauges, set once per frame
+//
+// The profiler ends the counters frame and draws them in its overlay (F5). F6 starts/stops
+// writing one CSV row per frame.
+
+#if defined(ENABLE_PROFILER)
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+
+enum class Counter
+{
+    TilesTouched,
+    TilesClassified,
+    TransitionsToDry,
+    TransitionsToGrass,
+    TransitionsToSnow,
+    ParticlesEmitted,
+    ParticlesRejected,
+    ParticlesAlive,
+    ParticlesCulled,
+    FxRectsAdded,
+    FxRectsMerged,
+    FxRectsAlive,
+    SoundRequests,
+    SoundsPlayed,
+    SchedulerTasks,
+    DrawCalls,
+    BatchFlushes,
+    FrameArenaBytes,
+    Count
+};
+
+inline constexpr const char *COUNTER_NAMES[] = {
+    "tiles_touched",
+    "tiles_classified",
+    "transitions_to_dry",
+    "transitions_to_grass",
+    "transitions_to_snow",
+    "particles_emitted",
+    "particles_rejected",
+    "particles_alive",
+    "particles_culled",
+    "fx_rects_added",
+    "fx_rects_merged",
+    "fx_rects_alive",
+    "sound_requests",
+    "sounds_played",
+    "scheduler_tasks",
+    "draw_calls",
+    "batch_flushes",
+    "frame_arena_bytes",
+};
+static_assert(sizeof(COUNTER_NAMES) / sizeof(COUNTER_NAMES[0]) == static_cast<int>(Counter::Count));
+
+inline constexpr const char *COUNTERS_CSV_PATH = "counters.csv";
+
+class Counters
+{
+private:
+    // Atomic because the audio and loader threads count too
+    inline static std::atomic<int64_t> values[static_cast<int>(Counter::Count)];
+    inline static int64_t lastFrame[static_cast<int>(Counter::Count)];
+    inline static uint64_t frame = 0;
+    inline static FILE *csv = nullptr;
+    inline static bool overlayVisible = false;
+    inline static bool hooked = false;
+
+    static void HookDrawCalls();
+
+public:
+    static void Add(Counter counter, int64_t amount)
+    {
+        values[static_cast<int>(counter)].fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    static void Set(Counter counter, int64_t value)
+    {
+        values[static_cast<int>(counter)].store(value, std::memory_order_relaxed);
+    }
+
+    // Value of the last completed frame
+    static int64_t Get(Counter counter)
+    {
+        return lastFrame[static_cast<int>(counter)];
+    }
+
+    static void EndFrame();
+    static void DrawOverlay();
+    static bool StartDump(const char *path);
+    static void StopDump();
+};
+
+#define COUNTER_ADD(counter, amount) Counters::Add(counter, amount)
+#define COUNTER_SET(counter, value) Counters::Set(counter, value)
+
+#else
+
+#define COUNTER_ADD(counter, amount)
+#define COUNTER_SET(counter, value)
+
+#endif // ENABLE_PROFILER
+
+#endif // COUNTERS_H
@@ -1,69 +1,128 @@
 #include "FxManager.h"
+#include "Profiler.h"
+#include "Counters.h"
 #include <iostream>
+#include "rlgl.h"
 
-void FXManager::Init()
-{
-}
-
-void FXManager::Update(float deltaTime)
+static void UpdatePool(FadePool &pool, float deltaTime)
 {
-    for (auto it = fadeRects.begin(); it != fadeRects.end();)
+    int i = 0;
+    while (i < pool.count)
     {
-        it->endTime -= deltaTime;
-        if (it->endTime <= 0)
+        pool.rects[i].endTime -= deltaTime;
+        if (pool.rects[i].endTime <= 0)
         {
-            it = fadeRects.erase(it);
+            pool.rects[i] = pool.rects[--pool.count];
         }
         else
         {
-            ++it;
+            ++i;
         }
     }
+    pool.frameStart = pool.count;
+}
 
-    for (auto it = fadeEffectsInWorld.begin(); it != fadeEffectsInWorld.end();)
+// Draws all the fades of a pool as quads of a single batch
+static void DrawPool(const FadePool &pool)
+{
+    if (pool.count == 0)
     {
-        it->endTime -= deltaTime;
-        if (it->endTime <= 0)
-        {
-            it = fadeEffectsInWorld.erase(it);
-        }
-        else
+        return;
+    }
+
+    rlSetTexture(rlGetTextureIdDefault());
+    rlBegin(RL_QUADS);
+    for (int i = 0; i < pool.count; ++i)
+    {
+        const auto &fade = pool.rects[i];
+        Color color = Fade(fade.color, fade.endTime / fade.fadeDuration);
+        float left = fade.rect.x;
+        float top = fade.rect.y;
+        float right = fade.rect.x + fade.rect.width;
+        float bottom = fade.rect.y + fade.rect.height;
+
+        rlColor4ub(color.r, color.g, color.b, color.a);
+        rlTexCoord2f(0.0f, 0.0f);
+        rlVertex2f(left, top);
+        rlTexCoord2f(0.0f, 1.0f);
+        rlVertex2f(left, bottom);
+        rlTexCoord2f(1.0f, 1.0f);
+        rlVertex2f(right, bottom);
+        rlTexCoord2f(1.0f, 0.0f);
+        rlVertex2f(right, top);
+    }
+    rlEnd();
+    rlSetTexture(0);
+}
+
+static void AddToPool(FadePool &pool, Rectangle rect, Color color, float duration)
+{
+    // Tiles change in row order, so a fade that starts where the last one of this
+    // frame ends (same row, same look) just makes that span longer
+    if (pool.count > pool.frameStart)
+    {
+        auto &last = pool.rects[pool.count - 1];
+        if (last.fadeDuration == duration &&
+            last.color.r == color.r && last.color.g == color.g &&
+            last.color.b == color.b && last.color.a == color.a &&
+            last.rect.y == rect.y && last.rect.height == rect.height &&
+            last.rect.x + last.rect.width == rect.x)
         {
-            ++it;
+            last.rect.width += rect.width;
+            COUNTER_ADD(Counter::FxRectsMerged, 1);
+            return;
         }
     }
+
+    if (pool.count >= MAX_FADE_RECTS)
+    {
+        return;
+    }
+
+    pool.rects[pool.count++] = {rect, color, duration, duration};
+    COUNTER_ADD(Counter::FxRectsAdded, 1);
+}
+
+void FXManager::Init()
+{
+}
+
+void FXManager::Update(float deltaTime)
+{
+    PROFILE_SCOPE("FXManager::Update");
+    UpdatePool(fadeRects, deltaTime);
+    UpdatePool(fadeEffectsInWorld, deltaTime);
+    COUNTER_SET(Counter::FxRectsAlive, fadeRects.count + fadeEffectsInWorld.count);
 }
 
 void FXManager::Draw()
 {
-    for (const auto &rect : fadeRects)
-    {
-        DrawRectangleRec(rect.rect, Fade(rect.color, rect.endTime / rect.fadeDuration));
-    }
+    PROFILE_SCOPE("FXManager::Draw");
+    DrawPool(fadeRects);
 }
 
 void FXManager::DrawEffectsInWorld()
 {
-    for (const auto &rect : fadeEffectsInWorld)
-    {
-        DrawRectangleRec(rect.rect, Fade(rect.color, rect.endTime / rect.fadeDuration));
-    }
+    PROFILE_SCOPE("FXManager::DrawEffectsInWorld");
+    DrawPool(fadeEffectsInWorld);
 }
 
 void FXManager::Cleanup()
 {
-    fadeRects.clear();
-    fadeEffectsInWorld.clear();
+    fadeRects.count = 0;
+    fadeRects.frameStart = 0;
+    fadeEffectsInWorld.count = 0;
+    fadeEffectsInWorld.frameStart = 0;
 }
 
 void FXManager::AddFadeRect(Rectangle rect, Color color, float duration, bool inWorld)
 {
     if (inWorld)
     {
-        fadeEffectsInWorld.push_back({rect, color, duration, duration});
+        AddToPool(fadeEffectsInWorld, rect, color, duration);
     }
     else
     {
-        fadeRects.push_back({rect, color, duration, duration});
+        AddToPool(fadeRects, rect, color, duration);
     }
 }
@@ -6,6 +6,8 @@
 #include <vector>
 #include <string>
 
+inline constexpr int MAX_FADE_RECTS = 1024;
+
 struct FadeRectangle
 {
     Rectangle rect;
@@ -14,11 +16,20 @@ struct FadeRectangle
     float fadeDuration;
 };
 
+// Fixed pool of fades, removed with swap-remove. The rects added since the last update
+// are at the end of the pool ([frameStart, count)) so they can be merged as they come
+struct FadePool
+{
+    FadeRectangle rects[MAX_FADE_RECTS];
+    int count = 0;
+    int frameStart = 0;
+};
+
 class FXManager
 {
 private:
-    inline static std::vector<FadeRectangle> fadeRects;
-    inline static std::vector<FadeRectangle> fadeEffectsInWorld;
+    inline static FadePool fadeRects;
+    inline static FadePool fadeEffectsInWorld;
 
 public:
     static void Init();
@@ -29,4 +40,4 @@ public:
     static void Cleanup();
 };
 
-#endif // FXMANAGER_H
\ No newline at end of file
+#endif // FXMANAGER_H
@@ -11,6 +11,14 @@ public:
     virtual void Update(float deltaTime) = 0;
     virtual void Render() = 0;
     virtual void Unload() = 0;
+
+    // Asynchronous loading, used by the SceneManager when changing scenes.
+    // LoadAsync runs on a worker thread and must only touch CPU data (files, images, parsing).
+    // FinalizeLoad runs on the main thread every frame until it returns true, uploading to the GPU
+    // and spending at most timeBudget seconds per call. Scenes that don't split their loading
+    // just get loaded in one go.
+    virtual void LoadAsync() {}
+    virtual bool FinalizeLoad(double timeBudget) { Load(); return true; }
 public:
     std::string name;
 };
@@ -0,0 +1,78 @@
+#ifndef HUDTEXT_H
+#define HUDTEXT_H
+
+#include <charconv>
+#include <cstring>
+#include <tuple>
+
+inline constexpr int HUD_TEXT_CAPACITY = 96;
+
+// Writes into a fixed buffer without allocating, the text is cut when the buffer is full
+class HudWriter
+{
+public:
+    HudWriter(char *buffer, int capacity) : end(buffer + capacity - 1), cursor(buffer)
+    {
+        *cursor = '\0';
+    }
+
+    void Append(const char *text)
+    {
+        while (*text != '\0' && cursor < end)
+        {
+            *cursor++ = *text++;
+        }
+        *cursor = '\0';
+    }
+
+    void Append(int value)
+    {
+        auto result = std::to_chars(cursor, end, value);
+        if (result.ec == std::errc())
+        {
+            cursor = result.ptr;
+        }
+        *cursor = '\0';
+    }
+
+    void Append(float value, int precision)
+    {
+        auto result = std::to_chars(cursor, end, value, std::chars_format::fixed, precision);
+        if (result.ec == std::errc())
+        {
+            cursor = result.ptr;
+        }
+        *cursor = '\0';
+    }
+
+private:
+    char *end;
+    char *cursor;
+};
+
+// Text bound to some values, only formatted again when one of them changes.
+// The returned pointer stays the same, so the rich text cache keeps its layout
+template <typename... Values>
+class HudText
+{
+public:
+    template <typename Format>
+    const char *Get(Format format, Values... current)
+    {
+        if (!formatted || values != std::make_tuple(current...))
+        {
+            values = std::make_tuple(current...);
+            HudWriter writer(text, HUD_TEXT_CAPACITY);
+            format(writer, current...);
+            formatted = true;
+        }
+        return text;
+    }
+
+private:
+    char text[HUD_TEXT_CAPACITY] = "";
+    std::tuple<Values...> values;
+    bool formatted = false;
+};
+
+#endif // HUDTEXT_H
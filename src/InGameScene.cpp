@@ -1,27 +1,74 @@
 #include "InGameScene.h"
 #include <iostream>
-#include <sstream>
-#include <iomanip>
 #include "constants.h"
 #include "raylib.h"
 #include "world.h"
 #include "utils.h"
 #include "SceneManager.h"
 #include "SoundManager.h"
+#include "FxManager.h"
+#include "Profiler.h"
+#include "Replay.h"
 
-InGameScene::InGameScene() : GameScene("InGameScene") {}
-
-void DrawFormattedText(int springTiles, int totalTiles, float percentage, int posX, int posY)
+// Sounds and screen effects of the simulation events, the world itself doesn't know about them.
+// The world is updated on the main thread, so the events can use PlaySound
+class GameWorldEvents : public WorldEventSink
 {
-    std::ostringstream ss;
+public:
+    void OnTileChanged(World *world, Rectangle where, TileType from, TileType to) override
+    {
+        FXManager::AddFadeRect(where, WHITE, 0.5f, true);
 
-    // Build the formatted string with fixed-point notation and two decimal places
-    ss << "Spring Tiles: " << springTiles << " / " << totalTiles
-       << " (" << std::fixed << std::setprecision(2) << percentage << "%)";
+        Vector2 center = {where.x + where.width / 2.0f, where.y + where.height / 2.0f};
+        switch (to)
+        {
+        case TileType::Dry:
+            SoundManager::QueueSound(SFX_DRY, 0.3f, 0.1f, center);
+            break;
+        case TileType::Grass:
+            SoundManager::QueueSound(SFX_GRASS, 0.1f, 0.5f, center);
+            break;
+        case TileType::Snow:
+            SoundManager::QueueSound(SFX_FREEZE, 0.3f, 0.1f, center);
+            break;
+        default:
+            break;
+        }
+    }
 
-    // Draw the text on the screen using Raylib
-    DrawText(ss.str().c_str(), posX, posY, 4, WHITE);
-}
+    void OnPlayerHealthChanged(World *world, float lastHealth, float newHealth) override
+    {
+        if (newHealth < lastHealth)
+        {
+            FXManager::AddFadeRect(Rectangle{0, 0, static_cast<float>(GetScreenWidth()), static_cast<float>(GetScreenHeight())}, RED, 0.025f, false);
+            SoundManager::PlaySound(SFX_HIT, 0.3f, 0.1f);
+        }
+        else
+        {
+            SoundManager::PlaySound(SFX_HEAL, 0.3f, 0.1f);
+        }
+    }
+
+    void OnElementalGrabbed(World *world, const Elemental &elemental) override
+    {
+        SoundManager::PlaySound(SFX_GRAB, 0.3f, 0.1f);
+    }
+
+    void OnElementalReleased(World *world) override
+    {
+        SoundManager::PlaySound(SFX_RELEASE, 0.3f, 0.1f);
+    }
+
+    void OnVictory(World *world) override
+    {
+        SoundManager::PlaySound(SFX_VICTORY, 0.3f, 0.1f);
+        FXManager::AddFadeRect(Rectangle{0, 0, static_cast<float>(GetScreenWidth()), static_cast<float>(GetScreenHeight())}, GREEN, 0.025f, false);
+    }
+};
+
+static GameWorldEvents gameWorldEvents;
+
+InGameScene::InGameScene() : GameScene("InGameScene") {}
 
 void InGameScene::DrawStartingUI()
 {
@@ -33,29 +80,29 @@ void InGameScene::DrawStartingUI()
 
     // Render the level in big
     // Get the color 0, 255, 155, 255
-    float levelTextSize = MeasureText(FormatText("Level %i", world->currentLevel).c_str(), 40);
-    DrawRichText(FormatText("Level %i", world->currentLevel).c_str(), SCREEN_WIDTH / 2 - levelTextSize / 2, 150, 40, WHITE);
+    const char *levelTitle = levelTitleText.Get([](HudWriter &writer, int level) {
+        writer.Append("Level ");
+        writer.Append(level);
+    }, world->currentLevel);
+    DrawRichTextCentered(levelTitle, SCREEN_WIDTH / 2, 150, 40, WHITE);
 
     auto color = Color{0, 255, 155, 255};
-    auto name = GetLevelName(world->currentLevel);
-    float levelNameSize = MeasureText(name.c_str(), 15);
-    DrawRichText(name.c_str(), SCREEN_WIDTH / 2 - levelNameSize / 2, 200, 15, color);
+    DrawRichTextCentered(GetLevelName(world->currentLevel), SCREEN_WIDTH / 2, 200, 15, color);
 
-    float richTextSize = MeasureText("Press [Enter] to start the game", 22);
-    DrawRichText("Press <color=0,255,155,255> [Enter] </color> to start the game", SCREEN_WIDTH / 2 - richTextSize / 2, SCREEN_HEIGHT / 2 + 10, 22, WHITE);
+    DrawRichTextCentered("Press <color=0,255,155,255> [Enter] </color> to start the game", SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2 + 10, 22, WHITE);
 
     if (currentLevel < registeredWorlds.size())
     {
-        richTextSize = MeasureText("Press [N] to jump to the next level", 20);
-        DrawRichText("Press <color=0,255,155,255> [N] </color> to jump to the next level", SCREEN_WIDTH / 2 - richTextSize / 2, SCREEN_HEIGHT / 2 + 110, 20, WHITE);
+        DrawRichTextCentered("Press <color=0,255,155,255> [N] </color> to jump to the next level", SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2 + 110, 20, WHITE);
     }
 
     if (currentLevel > 1)
     {
-        richTextSize = MeasureText("Press [L] for previous level", 20);
-        DrawRichText("Press <color=0,255,155,255> [L] </color> for previous level", SCREEN_WIDTH / 2 - richTextSize / 2, SCREEN_HEIGHT / 2 + 150, 20, WHITE);
+        DrawRichTextCentered("Press <color=0,255,155,255> [L] </color> for previous level", SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2 + 150, 20, WHITE);
     }
 
+    DrawRichTextCentered("Hold <color=0,255,155,255> [Backspace] </color> while playing to rewind", SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2 + 50, 20, WHITE);
+
     DrawRichText("Press <color=150,0,0,255> [M] </color> Main Menu", 10, SCREEN_HEIGHT - 40, 20, WHITE);
 
     EnableVolumeOptions(true);
@@ -65,7 +112,7 @@ void InGameScene::UpdateStarting(float delta)
 {
     if (IsKeyDown(KEY_ENTER))
     {
-        gameState = GameState::PLAYING;
+        StartPlaying();
         SoundManager::PlaySound(SFX_GRASS, 0.5f, 0.1f);
         SoundManager::PlayMusic(SoundManager::gameMusic, 0.2f);
     }
@@ -78,8 +125,7 @@ void InGameScene::UpdateStarting(float delta)
     if (IsKeyReleased(KEY_N) && currentLevel < registeredWorlds.size())
     {
         currentLevel++;
-        DeleteWorld(world);
-        world = GetWorld(currentLevel);
+        ReplaceWorld(currentLevel);
         gameState = GameState::STARTING;
         SoundManager::PlaySound(SFX_GRASS, 0.5f, 0.1f);
     }
@@ -87,8 +133,7 @@ void InGameScene::UpdateStarting(float delta)
     if (IsKeyReleased(KEY_L) && currentLevel > 1)
     {
         currentLevel--;
-        DeleteWorld(world);
-        world = GetWorld(currentLevel);
+        ReplaceWorld(currentLevel);
         gameState = GameState::STARTING;
 
         SoundManager::PlaySound(SFX_GRASS, 0.5f, 0.1f);
@@ -102,27 +147,91 @@ void InGameScene::DrawInGameUI(const World *world)
     DrawRectangle(200, 15, 200, 10, RED);
     DrawRectangle(200, 15, 200 * world->springDominance, 10, LIME);
     // Draw total number of tiles / number of missing tiles
-    DrawFormattedText(world->springTiles, world->width * world->height,
-                      world->springDominance, 225, 15);
+    const char *springTiles = springTilesText.Get([](HudWriter &writer, int springTiles, int totalTiles, float percentage) {
+        writer.Append("Spring Tiles: ");
+        writer.Append(springTiles);
+        writer.Append(" / ");
+        writer.Append(totalTiles);
+        writer.Append(" (");
+        writer.Append(percentage, 2);
+        writer.Append("%)");
+    }, world->springTiles, world->width * world->height, world->springDominance);
+    DrawText(springTiles, 225, 15, 4, WHITE);
+
     // Print the level where we are
-    DrawText(FormatText("Level: %i", world->currentLevel).c_str(), SCREEN_WIDTH - 100, 15, 20, WHITE);
+    const char *level = levelText.Get([](HudWriter &writer, int level) {
+        writer.Append("Level: ");
+        writer.Append(level);
+    }, world->currentLevel);
+    DrawText(level, SCREEN_WIDTH - 100, 15, 20, WHITE);
 
     // Show the surender option on the top bar
     DrawRichText("Press <color=200,0,0,255>[R]</color> to restart", SCREEN_WIDTH - 400, 15, 20, WHITE);
 }
 
+void InGameScene::StartPlaying()
+{
+    gameState = GameState::PLAYING;
+    stepAccumulator = 0.0f;
+    pendingInput = WorldInput{};
+    history.Reset();
+    Replays::Begin(world);
+}
+
 void InGameScene::UpdatePlaying(float deltaTime)
 {
     SetShaderValue(entitiesShader, GetShaderLocation(entitiesShader, "time"), &timeElapsed, SHADER_UNIFORM_FLOAT);
-    UpdateWorld(world, deltaTime);
+    FXManager::Update(deltaTime);
+
+    // A key released between two steps still counts, in the next step only
+    WorldInput live = ReadWorldInput(world);
+    live.interact = live.interact || pendingInput.interact;
+    pendingInput = live;
+
+    if (IsKeyDown(KEY_BACKSPACE) && !Replays::IsPlayingBack() && history.GetSteps() > 0)
+    {
+        // The recording can't follow the attempt back, it ends where the rewind starts
+        Replays::End(world);
+        Scripts::Stop(victoryScript);
+        for (int i = 0; i < REWIND_STEPS_PER_FRAME && history.Rewind(world); i++)
+        {
+        }
+        stepAccumulator = 0.0f;
+    }
+    else
+    {
+        // Fixed steps so a session can be replayed, the frame time only decides how many run
+        stepAccumulator += deltaTime;
+        int steps = 0;
+        while (stepAccumulator >= WORLD_TIMESTEP && steps < WORLD_MAX_STEPS_PER_FRAME)
+        {
+            world->input = Replays::NextInput(world, pendingInput);
+            pendingInput.interact = false;
+            UpdateWorld(world, WORLD_TIMESTEP);
+            Replays::AfterStep(world, world->input);
+            history.Record(world);
+            stepAccumulator -= WORLD_TIMESTEP;
+            steps++;
+        }
+        if (steps == WORLD_MAX_STEPS_PER_FRAME)
+        {
+            stepAccumulator = 0.0f;
+        }
+    }
+    SoundManager::SetListener(GetPlayerCenter(world));
+    // Measured on the frames, the steps always last WORLD_TIMESTEP
+    world->particleSystem.AdaptBudget(deltaTime);
 
-    if (VictoryCondition(world) && world->timeInVictory > 1.0f)
+    if (VictoryCondition(world))
     {
-        gameState = GameState::VICTORY;
-        SoundManager::PlayMusic(SoundManager::titleMusic, 0.7f);
+        if (!Scripts::IsRunning(victoryScript))
+        {
+            victoryScript = Scripts::Start(VictorySequence());
+        }
     }
     else if (world->player.mortalEntity.isDead)
     {
+        Replays::End(world);
         gameState = GameState::GAME_OVER;
         SoundManager::PlaySound(SFX_HIT, 0.5f, 0.1f);
         SoundManager::StopMusic();
@@ -131,17 +240,25 @@ void InGameScene::UpdatePlaying(float deltaTime)
 
     if (IsKeyDown(KEY_R))
     {
-        DeleteWorld(world);
-        world = GetWorld(currentLevel);
+        RestartWorld();
         gameState = GameState::STARTING;
     }
 
     EnableVolumeOptions(false);
 }
 
+Script InGameScene::VictorySequence()
+{
+    // Let the victory animation of the world play before showing the victory screen
+    co_await Wait(1.0f);
+    Replays::End(world);
+    gameState = GameState::VICTORY;
+    SoundManager::PlayMusic(SoundManager::titleMusic, 0.7f);
+}
+
 void InGameScene::DrawPlaying(World *world)
 {
-    RenderWorld(world, &distortionShader, &entitiesShader);
+    RenderWorld(world, &distortionShader, &entitiesShader, &particlesShader);
     DrawInGameUI(world);
 }
 
@@ -156,13 +273,9 @@ void InGameScene::DrawGameOverUI()
     DrawRectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, Fade(BLACK, 0.9f));
     DrawRectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, Fade(RED, 0.2f));
 
-    float victoryTextSize = MeasureText("Game Over!", 40);
-    DrawRichText("<color=255,0,0,255>Game Over!</color>", SCREEN_WIDTH / 2 - victoryTextSize / 2, 150, 40, WHITE);
-
-    float richTextSize = MeasureText("Spring won't come this year...", 20);
+    DrawRichTextCentered("<color=255,0,0,255>Game Over!</color>", SCREEN_WIDTH / 2, 150, 40, WHITE);
 
-    richTextSize = MeasureText("Press [R] if it is NOT OVER yet!", 20);
-    DrawRichText("Press <color=0,255,155,255> [R] </color> if it is <color=0,255,155,255>NOT OVER</color> yet!", SCREEN_WIDTH / 2 - richTextSize / 2, SCREEN_HEIGHT / 2 + 60, 20, WHITE);
+    DrawRichTextCentered("Press <color=0,255,155,255> [R] </color> if it is <color=0,255,155,255>NOT OVER</color> yet!", SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2 + 60, 20, WHITE);
 
     DrawRichText("Press <color=150,0,0,255> [M] </color> Main Menu", 10, SCREEN_HEIGHT - 40, 20, WHITE);
 
@@ -173,9 +286,8 @@ void InGameScene::UpdateGameOver(float deltaTime)
 {
     if (IsKeyDown(KEY_R))
     {
-        DeleteWorld(world);
-        world = GetWorld(currentLevel);
-        gameState = GameState::PLAYING;
+        RestartWorld();
+        StartPlaying();
     }
 
     if (IsKeyDown(KEY_M))
@@ -198,40 +310,30 @@ void InGameScene::DrawVictoryUI()
 
     if (!gameComplete)
     {
-        float victoryTextSize = MeasureText("Victory!", 40);
-        DrawRichText("<color=0,255,155,255>Victory!</color>", SCREEN_WIDTH / 2 - victoryTextSize / 2, 150, 40, WHITE);
-        float explaationSize = MeasureText("Spring HAS come!", 25);
-        DrawRichText("Spring <color=0,255,155,255>HAS</color> come!", SCREEN_WIDTH / 2 - explaationSize / 2, 220, 25, WHITE);
+        DrawRichTextCentered("<color=0,255,155,255>Victory!</color>", SCREEN_WIDTH / 2, 150, 40, WHITE);
+        DrawRichTextCentered("Spring <color=0,255,155,255>HAS</color> come!", SCREEN_WIDTH / 2, 220, 25, WHITE);
     }
     else
     {
-        float explaationSize = MeasureText("Spring HAS come... FOREVER!", 25);
-        DrawRichText("Spring <color=0,255,155,255>HAS</color> come... <color=0,255,155,255>FOREVER</color>", SCREEN_WIDTH / 2 - explaationSize / 2, 150, 25, WHITE);
+        DrawRichTextCentered("Spring <color=0,255,155,255>HAS</color> come... <color=0,255,155,255>FOREVER</color>", SCREEN_WIDTH / 2, 150, 25, WHITE);
     }
 
-    float richTextSize = 0;
-
     // Show next world message
     if (!gameComplete)
     {
-        richTextSize = MeasureText("Press [N] to continue to the next level", 20);
-        DrawRichText("Press <color=0,255,155,255> [N] </color> to continue to the next level", SCREEN_WIDTH / 2 - richTextSize / 2, SCREEN_HEIGHT / 2 + 60, 20, WHITE);
+        DrawRichTextCentered("Press <color=0,255,155,255> [N] </color> to continue to the next level", SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2 + 60, 20, WHITE);
     }
     else
     {
-        richTextSize = MeasureText("Congratulations you FINISHED the game!!", 20);
-        DrawRichText("Congratulations you <color=0,255,155,255>FINISHED</color> the game!!", SCREEN_WIDTH / 2 - richTextSize / 2, SCREEN_HEIGHT / 2 - 60, 20, WHITE);
+        DrawRichTextCentered("Congratulations you <color=0,255,155,255>FINISHED</color> the game!!", SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2 - 60, 20, WHITE);
 
-        richTextSize = MeasureText("Thanks a lot for playing, it means the WORLD to ME...", 20);
-        DrawRichText("Thanks a lot for playing, it means the <color=0, 255, 155, 255> WORLD</color> to<color=0,255,155,255> ME</color>...", SCREEN_WIDTH / 2 - richTextSize / 2, SCREEN_HEIGHT / 2, 20, WHITE);
+        DrawRichTextCentered("Thanks a lot for playing, it means the <color=0, 255, 155, 255> WORLD</color> to<color=0,255,155,255> ME</color>...", SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2, 20, WHITE);
 
-        richTextSize = MeasureText("Press [M] to return to the main menu", 20);
-        DrawRichText("Press <color=150,0,0,255> [M] </color> to return to the main menu", SCREEN_WIDTH / 2 - richTextSize / 2, SCREEN_HEIGHT / 2 + 120, 20, WHITE);
+        DrawRichTextCentered("Press <color=150,0,0,255> [M] </color> to return to the main menu", SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2 + 120, 20, WHITE);
     }
 
     // Show repeat level message
-    richTextSize = MeasureText("Press [R] to repeat the level", 20);
-    DrawRichText("Press <color=0,255,155,255> [R] </color> to repeat the level", SCREEN_WIDTH / 2 - richTextSize / 2, SCREEN_HEIGHT / 2 + 150, 20, WHITE);
+    DrawRichTextCentered("Press <color=0,255,155,255> [R] </color> to repeat the level", SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2 + 150, 20, WHITE);
 
     EnableVolumeOptions(true);
 }
@@ -241,16 +343,14 @@ void InGameScene::UpdateVictory(float deltaTime)
     if (IsKeyDown(KEY_N) && currentLevel < registeredWorlds.size())
     {
         currentLevel++;
-        DeleteWorld(world);
-        world = GetWorld(currentLevel);
-        gameState = GameState::PLAYING;
+        ReplaceWorld(currentLevel);
+        StartPlaying();
     }
 
     if (IsKeyDown(KEY_R))
     {
-        DeleteWorld(world);
-        world = GetWorld(currentLevel);
-        gameState = GameState::PLAYING;
+        RestartWorld();
+        StartPlaying();
     }
 
     if (IsKeyDown(KEY_M) && currentLevel >= registeredWorlds.size())
@@ -268,8 +368,9 @@ void InGameScene::DrawInMenuUI(World *world)
     DrawInGameUI(world);
 }
 
-World *InGameScene::GetWorld(int level)
+World *InGameScene::GetWorld(int level, bool deferTextures)
 {
+    PROFILE_SCOPE("InGameScene::GetWorld");
     for (auto &w : registeredWorlds)
     {
         if (w.level == level)
@@ -278,17 +379,58 @@ World *InGameScene::GetWorld(int level)
             std::string worldPath = "resources/worlds/level_" + levelStr + "_ground.csv";
             std::string entitiesPath = "resources/worlds/level_" + levelStr + "_entities.csv";
             std::string tutorialPath = "resources/worlds/level_" + levelStr + "_tutorial.txt";
-            return LoadWorld(level, worldPath, entitiesPath, tutorialPath);
+            World *loaded = deferTextures ? LoadWorldData(level, worldPath, entitiesPath, tutorialPath)
+                                          : LoadWorld(level, worldPath, entitiesPath, tutorialPath);
+            loaded->events = &gameWorldEvents;
+            SaveWorld(loaded, pristineWorld);
+            return loaded;
         }
     }
     return nullptr;
 }
 
+void InGameScene::ReplaceWorld(int level)
+{
+    Scripts::Stop(victoryScript);
+    Replays::End(world);
+    history.Reset();
+    DeleteWorld(world);
+    FXManager::Cleanup();
+    world = GetWorld(level);
+}
+
+// Same level again, restored from the snapshot taken at load: no files, no textures
+void InGameScene::RestartWorld()
+{
+    Scripts::Stop(victoryScript);
+    Replays::End(world);
+    history.Reset();
+    FXManager::Cleanup();
+    if (!RestoreWorld(world, pristineWorld))
+    {
+        DeleteWorld(world);
+        world = GetWorld(currentLevel);
+        return;
+    }
+    // Every attempt plays out differently, like a level loaded again
+    SeedWorld(world, std::random_device{}());
+}
+
 void InGameScene::Load()
+{
+    LoadAsync();
+    while (!FinalizeLoad(SCENE_FINALIZE_BUDGET))
+    {
+    }
+}
+
+void InGameScene::LoadAsync()
 {
     gameState = GameState::STARTING;
-    currentLevel = 1;
+    // A replay starts on its own level
+    currentLevel = Replays::IsPlayingBack() ? Replays::GetPlaybackLevel() : 1;
 
+    registeredWorlds.clear();
     RegisterWorld(1);
     RegisterWorld(2);
     RegisterWorld(3);
@@ -301,18 +443,65 @@ void InGameScene::Load()
     RegisterWorld(10);
     RegisterWorld(11);
 
-    this->world = GetWorld(currentLevel);
+    // Textures are uploaded later on the main thread by FinalizeLoad
+    this->world = GetWorld(currentLevel, true);
+
+    distortionShaderCode = LoadFileText(distortion_shader_path);
+    entitiesShaderCode = LoadFileText(entities_shader_path);
+    particlesShaderCode = LoadFileText(particles_shader_path);
 
-    distortionShader = LoadDistorionShader();
-    float resolution[2] = {(float)GetScreenWidth(), (float)GetScreenHeight()};
-    SetShaderValue(distortionShader, GetShaderLocation(distortionShader, "resolution"), resolution, SHADER_UNIFORM_VEC2);
+    backgroundImage = LoadImage("resources/splash.png");
 
-    entitiesShader = LoadEntitiesShader();
-    SetShaderValue(entitiesShader, GetShaderLocation(entitiesShader, "resolution"), resolution, SHADER_UNIFORM_VEC2);
+    loadStage = LoadStage::WORLD_TEXTURES;
+}
 
-    SoundManager::PlayMusic(SoundManager::gameMusic, 0.5f);
+bool InGameScene::FinalizeLoad(double timeBudget)
+{
+    double deadline = GetTime() + timeBudget;
+
+    while (loadStage != LoadStage::DONE)
+    {
+        switch (loadStage)
+        {
+        case LoadStage::WORLD_TEXTURES:
+            if (UploadWorldTextures(world, deadline))
+            {
+                FXManager::Init();
+                loadStage = LoadStage::SHADERS;
+            }
+            break;
+        case LoadStage::SHADERS:
+        {
+            distortionShader = LoadShaderFromCode(distortionShaderCode);
+            entitiesShader = LoadShaderFromCode(entitiesShaderCode);
+            particlesShader = LoadShaderFromCode(particlesShaderCode);
+            distortionShaderCode = nullptr;
+            entitiesShaderCode = nullptr;
+            particlesShaderCode = nullptr;
+
+            float resolution[2] = {(float)GetScreenWidth(), (float)GetScreenHeight()};
+            SetShaderValue(distortionShader, GetShaderLocation(distortionShader, "resolution"), resolution, SHADER_UNIFORM_VEC2);
+            SetShaderValue(entitiesShader, GetShaderLocation(entitiesShader, "resolution"), resolution, SHADER_UNIFORM_VEC2);
+            loadStage = LoadStage::BACKGROUND;
+            break;
+        }
+        case LoadStage::BACKGROUND:
+            background = LoadTextureFromImage(backgroundImage);
+            UnloadImage(backgroundImage);
+            SoundManager::PlayMusic(SoundManager::gameMusic, 0.5f);
+            loadStage = LoadStage::DONE;
+            break;
+        case LoadStage::DONE:
+            break;
+        }
+
+        if (GetTime() > deadline)
+        {
+            break;
+        }
+    }
 
-    background = LoadTexture("resources/splash.png");
+    return loadStage == LoadStage::DONE;
 }
 
 void InGameScene::Update(float deltaTime)
@@ -374,12 +563,17 @@ void InGameScene::RegisterWorld(int level)
 void InGameScene::Unload()
 {
     registeredWorlds.clear();
+    Scripts::Stop(victoryScript);
+    Replays::End(world);
     DeleteWorld(world);
+    FXManager::Cleanup();
     UnloadShader(distortionShader);
     UnloadShader(entitiesShader);
+    UnloadShader(particlesShader);
+    UnloadTexture(background);
 }
 
-std::string InGameScene::GetLevelName(int level)
+const char *InGameScene::GetLevelName(int level)
 {
     switch (level)
     {
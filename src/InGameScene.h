@@ -5,6 +5,9 @@
 #include "raylib.h"
 #include <vector>   
 #include "world.h"
+#include "Coroutine.h"
+#include "HudText.h"
+#include "Rewind.h"
 
 enum class GameState 
 {
@@ -22,7 +25,18 @@ public:
     virtual void Update(float deltaTime) override;
     virtual void Render() override;
     virtual void Unload() override;
+    virtual void LoadAsync() override;
+    virtual bool FinalizeLoad(double timeBudget) override;
 private:
+    // Main thread steps left after LoadAsync, in order
+    enum class LoadStage
+    {
+        WORLD_TEXTURES,
+        SHADERS,
+        BACKGROUND,
+        DONE
+    };
+
     void DrawStartingUI();
     void DrawInGameUI(const World * world);
     void DrawPlaying(World * world);
@@ -30,6 +44,7 @@ private:
     void DrawInMenuUI(World * world);
     void DrawVictoryUI();
 
+    void StartPlaying();
     void UpdateStarting(float deltaTime);
     void UpdatePlaying(float deltaTime);
     void UpdateGameOver(float deltaTime);
@@ -37,20 +52,41 @@ private:
     void UpdateInMenuUI(float deltaTime);
 
     void RegisterWorld(int level);
-    World* GetWorld(int level);
+    World* GetWorld(int level, bool deferTextures = false);
+    void ReplaceWorld(int level);
+    void RestartWorld();
+
+    Script VictorySequence();
 
-    std::string GetLevelName(int level);
+    const char *GetLevelName(int level);
 
 private:
     World* world;
+    // State of the world right after loading, restarts go back to it
+    WorldSnapshot pristineWorld;
+    // Steps of the current attempt, played backwards while [Backspace] is held
+    WorldHistory history;
     Shader distortionShader;
     Shader entitiesShader;
+    Shader particlesShader;
     float timeElapsed = 0.0f;
     GameState gameState = GameState::GAME_OVER;
     Texture2D background;
+    Image backgroundImage;
+    char *distortionShaderCode = nullptr;
+    char *entitiesShaderCode = nullptr;
+    char *particlesShaderCode = nullptr;
+    LoadStage loadStage = LoadStage::DONE;
+    float stepAccumulator = 0.0f;
+    WorldInput pendingInput;
 
     std::vector<RegisteredWorld> registeredWorlds;
     size_t currentLevel = 2;
+    ScriptHandle victoryScript;
+
+    HudText<int> levelTitleText;
+    HudText<int> levelText;
+    HudText<int, int, float> springTilesText;
 };
 
 #endif // INGAMESCENE_H
@@ -0,0 +1,102 @@
+#ifndef INPLACE_FUNCTION_H
+#define INPLACE_FUNCTION_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Move-only std::function replacement that stores the callable inside the object,
+// it never allocates. Callables bigger than Capacity are rejected at compile time.
+template <typename Signature, size_t Capacity = 48>
+class InplaceFunction;
+
+template <typename R, typename... Args, size_t Capacity>
+class InplaceFunction<R(Args...), Capacity>
+{
+public:
+    InplaceFunction() = default;
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, InplaceFunction>>>
+    InplaceFunction(F &&function)
+    {
+        using Callable = std::decay_t<F>;
+        static_assert(sizeof(Callable) <= Capacity, "Callable is too big for InplaceFunction, capture less");
+        static_assert(alignof(Callable) <= alignof(std::max_align_t), "Callable is over-aligned");
+
+        new (storage) Callable(std::forward<F>(function));
+        invoker = [](void *callable, Args &&...args) -> R {
+            return (*static_cast<Callable *>(callable))(std::forward<Args>(args)...);
+        };
+        manager = [](void *destination, void *source) {
+            // Moves source into destination, or destroys source when there is no destination
+            if (destination)
+            {
+                new (destination) Callable(std::move(*static_cast<Callable *>(source)));
+            }
+            static_cast<Callable *>(source)->~Callable();
+        };
+    }
+
+    InplaceFunction(InplaceFunction &&other) noexcept
+    {
+        MoveFrom(other);
+    }
+
+    InplaceFunction &operator=(InplaceFunction &&other) noexcept
+    {
+        if (this != &other)
+        {
+            Reset();
+            MoveFrom(other);
+        }
+        return *this;
+    }
+
+    InplaceFunction(const InplaceFunction &) = delete;
+    InplaceFunction &operator=(const InplaceFunction &) = delete;
+
+    ~InplaceFunction()
+    {
+        Reset();
+    }
+
+    R operator()(Args... args)
+    {
+        return invoker(storage, std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const
+    {
+        return invoker != nullptr;
+    }
+
+    void Reset()
+    {
+        if (manager)
+        {
+            manager(nullptr, storage);
+        }
+        invoker = nullptr;
+        manager = nullptr;
+    }
+
+private:
+    void MoveFrom(InplaceFunction &other)
+    {
+        if (other.manager)
+        {
+            other.manager(storage, other.storage);
+        }
+        invoker = other.invoker;
+        manager = other.manager;
+        other.invoker = nullptr;
+        other.manager = nullptr;
+    }
+
+    alignas(std::max_align_t) unsigned char storage[Capacity];
+    R (*invoker)(void *, Args &&...) = nullptr;
+    void (*manager)(void *, void *) = nullptr;
+};
+
+#endif // INPLACE_FUNCTION_H
@@ -0,0 +1,30 @@
+#include "LoadingScene.h"
+#include "raylib.h"
+#include "constants.h"
+
+LoadingScene::LoadingScene() : GameScene("Loading") {}
+
+void LoadingScene::Load()
+{
+    timeElapsed = 0.0f;
+}
+
+void LoadingScene::Update(float deltaTime)
+{
+    timeElapsed += deltaTime;
+}
+
+void LoadingScene::Render()
+{
+    DrawRectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, BLACK);
+
+    // Measure without the dots so the text doesn't move while they animate
+    int textSize = MeasureText("Loading", 20);
+    int dots = (int)(timeElapsed * 3.0f) % 4;
+    const char *texts[] = {"Loading", "Loading.", "Loading..", "Loading..."};
+    DrawText(texts[dots], SCREEN_WIDTH / 2 - textSize / 2, SCREEN_HEIGHT / 2 - 10, 20, WHITE);
+}
+
+void LoadingScene::Unload()
+{
+}
@@ -0,0 +1,18 @@
+#ifndef LOADINGSCENE_H
+#define LOADINGSCENE_H
+
+#include "GameScene.h"
+
+// Shown by the SceneManager while the next scene is loading
+class LoadingScene : public GameScene {
+public:
+    LoadingScene();
+    virtual void Load() override;
+    virtual void Update(float deltaTime) override;
+    virtual void Render() override;
+    virtual void Unload() override;
+private:
+    float timeElapsed = 0.0f;
+};
+
+#endif // LOADINGSCENE_H
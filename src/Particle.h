@@ -1,4 +1,5 @@
 #include "raylib.h"
+#include "rlgl.h"
 #include <cmath>
 #include <iostream>
 class Particle {
@@ -12,16 +13,30 @@ public:
     inline Particle(Vector2 pos, Vector2 vel, float rad, Color col, float lifeTime) :
         position(pos), velocity(vel), radius(rad), life(lifeTime), color(col) {}
 
-    inline void Update(float deltaTime) {
+    // time is the clock of the particle system, so the sway doesn't depend on the wall clock
+    inline void Update(float deltaTime, float time) {
         position.x += velocity.x * deltaTime;
-        position.y += velocity.y * deltaTime + 0.1f * sin(GetTime()) * 5.0f;
+        position.y += velocity.y * deltaTime + 0.1f * sin(time) * 5.0f;
         life -= deltaTime;
         radius -= deltaTime * 5.0f;
         if (radius < 0) radius = 0;
     }
 
+    // Appends the particle quad to the active batch, must be called between rlBegin(RL_QUADS) and rlEnd()
     inline void Draw() const {
-        DrawCircle(static_cast<int>(position.x), static_cast<int>(position.y), radius, color);
+        rlColor4ub(color.r, color.g, color.b, color.a);
+
+        rlTexCoord2f(0.0f, 0.0f);
+        rlVertex2f(position.x - radius, position.y - radius);
+
+        rlTexCoord2f(0.0f, 1.0f);
+        rlVertex2f(position.x - radius, position.y + radius);
+
+        rlTexCoord2f(1.0f, 1.0f);
+        rlVertex2f(position.x + radius, position.y + radius);
+
+        rlTexCoord2f(1.0f, 0.0f);
+        rlVertex2f(position.x + radius, position.y - radius);
     }
 
     inline bool IsAlive() const {
@@ -0,0 +1,134 @@
+#include "ParticleEmitter.h"
+#include <cmath>
+#include "raymath.h"
+#include "utils.h"
+
+static Vector2 SampleShape(const ParticleEmitter &emitter, std::mt19937 &random)
+{
+    switch (emitter.shape)
+    {
+    case EmitterShape::Area:
+        return Vector2{GetRandomFloat(random, -emitter.outerRadius, emitter.outerRadius),
+                       GetRandomFloat(random, -emitter.outerRadius, emitter.outerRadius)};
+    case EmitterShape::Ring:
+    {
+        float angle = GetRandomFloat(random, 0.0f, 2.0f * PI);
+        float distance = GetRandomFloat(random, emitter.innerRadius, emitter.outerRadius);
+        return Vector2{cosf(angle) * distance, sinf(angle) * distance};
+    }
+    case EmitterShape::Disc:
+    default:
+    {
+        // sqrt keeps the points evenly spread over the disc surface
+        float angle = GetRandomFloat(random, 0.0f, 2.0f * PI);
+        float distance = emitter.outerRadius * sqrtf(GetRandomFloat(random, 0.0f, 1.0f));
+        return Vector2{cosf(angle) * distance, sinf(angle) * distance};
+    }
+    }
+}
+
+void EmitBurst(const ParticleEmitter &emitter, ParticleSystem &system, Vector2 origin, int count, Vector2 target)
+{
+    auto &random = system.GetRandom();
+    for (int i = 0; i < count; ++i)
+    {
+        Vector2 offset = SampleShape(emitter, random);
+        Vector2 position = emitter.spawnOnShape ? Vector2Add(origin, offset) : origin;
+
+        Vector2 velocity;
+        if (emitter.motion == EmitterMotion::ToTarget)
+        {
+            // Reach the target right when the particle dies
+            velocity = Vector2Scale(Vector2Subtract(target, position), 1.0f / emitter.lifeTime);
+        }
+        else
+        {
+            float speed = GetRandomFloat(random, emitter.minSpeed, emitter.maxSpeed);
+            Vector2 direction = Vector2Normalize(offset);
+            velocity = Vector2Scale(direction, emitter.motion == EmitterMotion::Inward ? -speed : speed);
+        }
+
+        Color color = Fade(emitter.color, GetRandomFloat(random, emitter.minAlpha, emitter.maxAlpha));
+        system.Emit(position, velocity, emitter.particleRadius, color, emitter.lifeTime);
+    }
+}
+
+void UpdateEmitter(ParticleEmitter &emitter, ParticleSystem &system, Vector2 origin, float deltaTime, Vector2 target)
+{
+    if (emitter.rate <= 0.0f || emitter.burstCount <= 0)
+        return;
+
+    emitter.accumulator += emitter.rate * deltaTime;
+    int bursts = static_cast<int>(emitter.accumulator);
+    if (bursts == 0)
+        return;
+    emitter.accumulator -= bursts;
+
+    float extent = emitter.outerRadius + emitter.particleRadius;
+    Rectangle area = {origin.x - extent, origin.y - extent, extent * 2.0f, extent * 2.0f};
+    if (emitter.motion != EmitterMotion::ToTarget && !system.IsVisible(area))
+        return;
+
+    // Thin the burst with the distance to the camera, the fractional part is rolled once
+    float wanted = bursts * emitter.burstCount * system.GetEmissionDensity(emitter.motion == EmitterMotion::ToTarget ? target : origin);
+    int count = static_cast<int>(wanted);
+    if (GetRandomFloat(system.GetRandom(), 0.0f, 1.0f) < wanted - count)
+        count++;
+
+    EmitBurst(emitter, system, origin, count, target);
+}
+
+ParticleEmitter MakeElementalAuraEmitter(Color color, int range, float tileSize)
+{
+    ParticleEmitter emitter;
+    emitter.shape = EmitterShape::Area;
+    emitter.motion = EmitterMotion::Outward;
+    emitter.spawnOnShape = false;
+    emitter.outerRadius = (range + 0.5f) * tileSize;
+    emitter.minSpeed = 0.0f;
+    emitter.maxSpeed = 25.0f;
+    emitter.particleRadius = 5.0f;
+    emitter.lifeTime = 1.0f;
+    emitter.color = color;
+    emitter.minAlpha = 0.0f;
+    emitter.maxAlpha = 0.5f;
+
+    // Half of the tiles in range on each burst, a burst every 0.6 seconds on average
+    int side = range * 2 + 1;
+    emitter.burstCount = side * side / 2;
+    emitter.rate = 1.0f / 0.6f;
+    return emitter;
+}
+
+ParticleEmitter MakeStaffTrailEmitter(Color color)
+{
+    ParticleEmitter emitter;
+    emitter.shape = EmitterShape::Disc;
+    emitter.motion = EmitterMotion::ToTarget;
+    emitter.spawnOnShape = true;
+    emitter.particleRadius = 5.0f;
+    emitter.lifeTime = 1.0f;
+    emitter.color = color;
+    emitter.minAlpha = 0.5f;
+    emitter.maxAlpha = 0.5f;
+    emitter.rate = 90.0f;
+    emitter.burstCount = 1;
+    return emitter;
+}
+
+ParticleEmitter MakePlayerBurstEmitter(Color color, float particleRadius, bool inward)
+{
+    ParticleEmitter emitter;
+    emitter.shape = EmitterShape::Ring;
+    emitter.motion = inward ? EmitterMotion::Inward : EmitterMotion::Outward;
+    emitter.spawnOnShape = true;
+    emitter.innerRadius = 10.0f;
+    emitter.outerRadius = 50.0f;
+    emitter.minSpeed = 20.0f;
+    emitter.maxSpeed = 200.0f;
+    emitter.particleRadius = particleRadius;
+    emitter.lifeTime = 0.7f;
+    emitter.color = color;
+    emitter.burstCount = 10;
+    return emitter;
+}
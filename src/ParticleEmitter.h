@@ -0,0 +1,60 @@
+#ifndef PARTICLEEMITTER_H
+#define PARTICLEEMITTER_H
+
+#include "ParticleSystem.h"
+
+enum class EmitterShape
+{
+    Disc = 0,
+    Ring = 1,
+    Area = 2,
+    Count
+};
+
+enum class EmitterMotion
+{
+    Outward = 0,
+    Inward = 1,
+    ToTarget = 2,
+    Count
+};
+
+struct ParticleEmitter
+{
+    EmitterShape shape = EmitterShape::Disc;
+    EmitterMotion motion = EmitterMotion::Outward;
+
+    // If true particles are born on the shape, otherwise they are born on the origin and
+    // travel towards the sampled point of the shape
+    bool spawnOnShape = true;
+
+    // Disc and Ring use both radius, Area uses outerRadius as the half size of the square
+    float innerRadius = 0.0f;
+    float outerRadius = 0.0f;
+
+    float minSpeed = 0.0f;
+    float maxSpeed = 0.0f;
+
+    float particleRadius = 5.0f;
+    float lifeTime = 1.0f;
+    Color color = WHITE;
+    float minAlpha = 1.0f;
+    float maxAlpha = 1.0f;
+
+    // Bursts per second (0 for emitters that only fire with EmitBurst) and particles per burst
+    float rate = 0.0f;
+    int burstCount = 0;
+    float accumulator = 0.0f;
+};
+
+// Accumulates the emission rate and spawns the pending bursts in a single pass,
+// the target is only used by ToTarget emitters
+void UpdateEmitter(ParticleEmitter &emitter, ParticleSystem &system, Vector2 origin, float deltaTime, Vector2 target = {0, 0});
+void EmitBurst(const ParticleEmitter &emitter, ParticleSystem &system, Vector2 origin, int count, Vector2 target = {0, 0});
+
+// Presets
+ParticleEmitter MakeElementalAuraEmitter(Color color, int range, float tileSize);
+ParticleEmitter MakeStaffTrailEmitter(Color color);
+ParticleEmitter MakePlayerBurstEmitter(Color color, float particleRadius, bool inward);
+
+#endif //PARTICLEEMITTER_H
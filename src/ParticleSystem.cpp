@@ -3,22 +3,160 @@
 //
 
 #include "ParticleSystem.h"
+#include "Profiler.h"
+#include "Counters.h"
+#include <algorithm>
+#include <cmath>
+
+inline constexpr float VIEW_MARGIN = 64.0f;
+inline constexpr float TARGET_FRAME_TIME = 1.0f / 60.0f;
+inline constexpr size_t MIN_PARTICLE_BUDGET = 256;
+
+// Max number of alive particles and base emission density for each quality level
+inline constexpr size_t MAX_PARTICLE_BUDGET[] = {1024, 4096, 8192};
+inline constexpr float QUALITY_DENSITY[] = {0.35f, 0.65f, 1.0f};
+
+ParticleSystem::ParticleSystem(std::pmr::memory_resource *resource) : particles(resource) {
+    budget = MAX_PARTICLE_BUDGET[static_cast<int>(quality)];
+    particles.reserve(GetMaxBudget());
+}
+
+size_t ParticleSystem::GetMaxBudget() {
+    return MAX_PARTICLE_BUDGET[static_cast<int>(ParticleQuality::High)];
+}
+
+void ParticleSystem::Emit(Vector2 position, Vector2 velocity, float radius, Color color, float lifeTime) {
+    if (particles.size() >= budget) {
+        COUNTER_ADD(Counter::ParticlesRejected, 1);
+        return;
+    }
+
+    if (!IsVisible(Rectangle{position.x - radius, position.y - radius, radius * 2.0f, radius * 2.0f})) {
+        COUNTER_ADD(Counter::ParticlesRejected, 1);
+        return;
+    }
+
+    particles.emplace_back(position, velocity, radius, color, lifeTime);
+    COUNTER_ADD(Counter::ParticlesEmitted, 1);
+}
+
+void ParticleSystem::SaveState(ParticleSystemState &state) const {
+    state.particles.assign(particles.begin(), particles.end());
+    state.random = random;
+    state.time = time;
+}
+
+void ParticleSystem::RestoreState(const ParticleSystemState &state) {
+    particles.assign(state.particles.begin(), state.particles.end());
+    random = state.random;
+    time = state.time;
+}
 
 void ParticleSystem::Update(float deltaTime) {
+    PROFILE_SCOPE("ParticleSystem::Update");
+    time += deltaTime;
 
     for (auto it = particles.begin(); it != particles.end(); ) {
-        it->Update(deltaTime);
+        it->Update(deltaTime, time);
         if (!it->IsAlive()) {
             it = particles.erase(it);
         } else {
             ++it;
         }
     }
+    COUNTER_SET(Counter::ParticlesAlive, particles.size());
 
 }
 
+// All the particles go out as quads of a single batch (one draw call), the circle shape
+// is computed in the particles shader so the CPU cost is just four vertices per particle
 void ParticleSystem::Draw() {
-    for (auto& particle : particles) {
+    PROFILE_SCOPE("ParticleSystem::Draw");
+    if (particles.empty()) {
+        return;
+    }
+
+    rlSetTexture(rlGetTextureIdDefault());
+    rlBegin(RL_QUADS);
+    for (const auto& particle : particles) {
+        if (particle.radius <= 0) {
+            continue;
+        }
+        if (hasView &&
+            (particle.position.x + particle.radius < view.x ||
+             particle.position.x - particle.radius > view.x + view.width ||
+             particle.position.y + particle.radius < view.y ||
+             particle.position.y - particle.radius > view.y + view.height)) {
+            COUNTER_ADD(Counter::ParticlesCulled, 1);
+            continue;
+        }
         particle.Draw();
     }
-}
\ No newline at end of file
+    rlEnd();
+    rlSetTexture(0);
+}
+
+void ParticleSystem::SetView(Rectangle viewRect) {
+    view = viewRect;
+    hasView = view.width > 0 && view.height > 0;
+}
+
+void ParticleSystem::SetQuality(ParticleQuality newQuality) {
+    quality = newQuality;
+    budget = std::min(budget, MAX_PARTICLE_BUDGET[static_cast<int>(quality)]);
+}
+
+bool ParticleSystem::IsVisible(Rectangle area) const {
+    if (!hasView) {
+        return true;
+    }
+
+    return area.x + area.width >= view.x - VIEW_MARGIN &&
+           area.x <= view.x + view.width + VIEW_MARGIN &&
+           area.y + area.height >= view.y - VIEW_MARGIN &&
+           area.y <= view.y + view.height + VIEW_MARGIN;
+}
+
+float ParticleSystem::GetEmissionDensity(Vector2 position) const {
+    float density = QUALITY_DENSITY[static_cast<int>(quality)];
+    if (!hasView) {
+        return density;
+    }
+
+    if (!IsVisible(Rectangle{position.x, position.y, 0, 0})) {
+        return 0.0f;
+    }
+
+    // Full density at the center of the view, a third of it on the edges
+    float halfWidth = view.width / 2.0f;
+    float halfHeight = view.height / 2.0f;
+    float dx = (position.x - (view.x + halfWidth)) / halfWidth;
+    float dy = (position.y - (view.y + halfHeight)) / halfHeight;
+    float distance = std::min(1.0f, sqrtf(dx * dx + dy * dy));
+
+    return density * (1.0f - distance * 0.66f);
+}
+
+void ParticleSystem::AdaptBudget(float frameTime) {
+    if (averageFrameTime <= 0.0f) {
+        averageFrameTime = frameTime;
+    }
+    averageFrameTime = averageFrameTime * 0.9f + frameTime * 0.1f;
+
+    // The quality follows the budget: one level down once the budget fits the level below,
+    // one level up once the budget of the current level is reached and there is time left
+    int level = static_cast<int>(quality);
+    size_t maxBudget = MAX_PARTICLE_BUDGET[level];
+    if (averageFrameTime > TARGET_FRAME_TIME * 1.1f) {
+        budget = std::max(MIN_PARTICLE_BUDGET, budget - budget / 10);
+        if (level > 0 && budget <= MAX_PARTICLE_BUDGET[level - 1]) {
+            SetQuality(static_cast<ParticleQuality>(level - 1));
+        }
+    } else if (averageFrameTime < TARGET_FRAME_TIME * 1.02f) {
+        if (budget >= maxBudget && level + 1 < static_cast<int>(ParticleQuality::Count)) {
+            SetQuality(static_cast<ParticleQuality>(level + 1));
+            maxBudget = MAX_PARTICLE_BUDGET[level + 1];
+        }
+        budget = std::min(maxBudget, budget + budget / 20 + 1);
+    }
+}
@@ -4,18 +4,77 @@
 #include "Particle.h"
 
 #include <vector>
+#include <memory_resource>
+#include <random>
+
+enum class ParticleQuality
+{
+    Low = 0,
+    Medium = 1,
+    High = 2,
+    Count
+};
+
+// Alive particles and the clock and generator of the emitters, kept by world snapshots
+struct ParticleSystemState {
+    std::vector<Particle> particles;
+    std::mt19937 random;
+    float time = 0.0f;
+};
 
 class ParticleSystem {
 private:
-    std::vector<Particle> particles;
+    // Reserved for the largest budget up front, emitting never allocates
+    std::pmr::vector<Particle> particles;
+
+    // Visible area in world coordinates, nothing is culled until the camera sets it
+    Rectangle view = {0, 0, 0, 0};
+    bool hasView = false;
+
+    ParticleQuality quality = ParticleQuality::High;
+    size_t budget = 0;
+    float averageFrameTime = 0.0f;
+
+    // Used by the emitters
+    std::mt19937 random;
+    float time = 0.0f;
 
 public:
-    void Emit(Vector2 position, Vector2 velocity, float radius, Color color, float lifeTime) {
-        particles.emplace_back(position, velocity, radius, color, lifeTime);
-    }
+    explicit ParticleSystem(std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+    void Emit(Vector2 position, Vector2 velocity, float radius, Color color, float lifeTime);
 
     void Update(float deltaTime);
     void Draw();
+
+    void SetView(Rectangle viewRect);
+    void SetQuality(ParticleQuality newQuality);
+    ParticleQuality GetQuality() const { return quality; }
+
+    // Checks if an area (in world coordinates) overlaps the view plus a small margin
+    bool IsVisible(Rectangle area) const;
+
+    // Fraction [0, 1] of the nominal emission that should be spawned at a position,
+    // it goes down with the distance to the center of the view and with the quality level
+    float GetEmissionDensity(Vector2 position) const;
+
+    // Grows or shrinks the particle budget, and the quality level with it, to keep the measured
+    // frame time on target. Call once per rendered frame
+    void AdaptBudget(float frameTime);
+    // Overrides the budget until the next AdaptBudget, for benchmarks and stress tests
+    void SetBudget(size_t maxParticles) { budget = maxParticles; }
+    size_t GetCount() const { return particles.size(); }
+    // Kills every particle, the clock and generator go on
+    void Clear() { particles.clear(); }
+    // Most particles alive at once with any quality level
+    static size_t GetMaxBudget();
+
+    void SaveState(ParticleSystemState &state) const;
+    // Never allocates, the particles fit in the reserved buffer
+    void RestoreState(const ParticleSystemState &state);
+
+    void Seed(uint32_t seed) { random.seed(seed); }
+    std::mt19937 &GetRandom() { return random; }
 };
 
 
@@ -0,0 +1,410 @@
+#include "Profiler.h"
+
+#if defined(ENABLE_PROFILER)
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include "raylib.h"
+#include "Counters.h"
+#include "AllocTracker.h"
+
+// Slot of the calling thread, released when the thread exits so loader threads can reuse it
+struct ThreadSlot
+{
+    ProfileThread *thread = nullptr;
+    bool full = false;
+
+    ~ThreadSlot()
+    {
+        if (thread != nullptr)
+        {
+            thread->depth = 0;
+            thread->inUse.store(false, std::memory_order_release);
+        }
+    }
+};
+
+static thread_local ThreadSlot threadSlot;
+
+uint64_t Profiler::Now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+static ProfileThread *ClaimSlot(ProfileThread *threads, const char *name)
+{
+    // Prefer a free slot with the same name, so the stats of a thread started again keep going
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (int i = 0; i < PROFILER_MAX_THREADS; i++)
+        {
+            auto &thread = threads[i];
+            if (pass == 0 && strcmp(thread.name, name) != 0)
+            {
+                continue;
+            }
+            bool expected = false;
+            if (thread.inUse.compare_exchange_strong(expected, true, std::memory_order_acquire))
+            {
+                if (pass == 1)
+                {
+                    // Node ids of another thread mean nothing here, start a new tree
+                    snprintf(thread.name, sizeof(thread.name), "%s", name);
+                    thread.firstRoot.store(-1, std::memory_order_release);
+                    thread.nodeCount.store(0, std::memory_order_release);
+                }
+                thread.depth = 0;
+                return &thread;
+            }
+        }
+    }
+    return nullptr;
+}
+
+ProfileThread *Profiler::GetThread()
+{
+    if (threadSlot.thread == nullptr && !threadSlot.full)
+    {
+        threadSlot.thread = ClaimSlot(threads, "Thread");
+        threadSlot.full = threadSlot.thread == nullptr;
+    }
+    return threadSlot.thread;
+}
+
+void Profiler::SetThreadName(const char *name)
+{
+    if (threadSlot.thread != nullptr)
+    {
+        if (strcmp(threadSlot.thread->name, name) == 0)
+        {
+            return;
+        }
+        threadSlot.thread->inUse.store(false, std::memory_order_release);
+    }
+    threadSlot.thread = ClaimSlot(threads, name);
+    threadSlot.full = threadSlot.thread == nullptr;
+}
+
+void Profiler::BeginScope(const char *name)
+{
+    auto thread = GetThread();
+    if (thread == nullptr)
+    {
+        return;
+    }
+
+    int depth = thread->depth;
+    if (depth >= PROFILER_MAX_DEPTH)
+    {
+        thread->depth++;
+        return;
+    }
+
+    int parent = depth > 0 ? thread->stack[depth - 1] : -1;
+    int node = -1;
+
+    // Scopes inside a zone that didn't fit in the node table are not recorded
+    if (depth == 0 || parent >= 0)
+    {
+        // Look for the zone among the children of the current one, in the order they were first entered
+        // Only this thread writes the links, it reads them relaxed
+        auto *link = parent >= 0 ? &thread->nodes[parent].firstChild : &thread->firstRoot;
+        node = link->load(std::memory_order_relaxed);
+        while (node >= 0 && thread->nodes[node].name != name)
+        {
+            link = &thread->nodes[node].nextSibling;
+            node = link->load(std::memory_order_relaxed);
+        }
+
+        int count = thread->nodeCount.load(std::memory_order_relaxed);
+        if (node < 0 && count < PROFILER_MAX_NODES)
+        {
+            node = count;
+            auto &created = thread->nodes[node];
+            created.name = name;
+            created.parent = parent;
+            created.depth = depth;
+            created.firstChild.store(-1, std::memory_order_relaxed);
+            created.nextSibling.store(-1, std::memory_order_relaxed);
+            thread->stats[node] = {};
+            thread->nodeCount.store(count + 1, std::memory_order_release);
+            link->store(node, std::memory_order_release);
+        }
+    }
+
+    thread->stack[depth] = node;
+#if defined(ENABLE_ALLOC_TRACKING)
+    auto allocs = AllocTracker::GetThreadTotal();
+    thread->stackAllocations[depth] = allocs.allocations;
+    thread->stackAllocBytes[depth] = allocs.bytes;
+#endif
+    thread->stackStart[depth] = Now();
+    thread->depth++;
+}
+
+void Profiler::EndScope()
+{
+    auto thread = threadSlot.thread;
+    if (thread == nullptr || thread->depth == 0)
+    {
+        return;
+    }
+
+    thread->depth--;
+    int depth = thread->depth;
+    if (depth >= PROFILER_MAX_DEPTH || thread->stack[depth] < 0)
+    {
+        return;
+    }
+
+    uint64_t end = Now();
+    uint32_t allocations = 0;
+    uint64_t allocBytes = 0;
+#if defined(ENABLE_ALLOC_TRACKING)
+    auto allocs = AllocTracker::GetThreadTotal();
+    allocations = static_cast<uint32_t>(allocs.allocations - thread->stackAllocations[depth]);
+    allocBytes = allocs.bytes - thread->stackAllocBytes[depth];
+#endif
+
+    uint64_t index = thread->written.load(std::memory_order_relaxed);
+    thread->events[index & (PROFILER_RING_SIZE - 1)] = {thread->stack[depth], thread->stackStart[depth], end,
+                                                        allocations, allocBytes};
+    thread->written.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::ConsumeEvents(ProfileThread &thread, int threadIndex)
+{
+    uint64_t written = thread.written.load(std::memory_order_acquire);
+    if (written - thread.read > PROFILER_RING_SIZE)
+    {
+        // The thread lapped us, the oldest events are lost
+        thread.read = written - PROFILER_RING_SIZE;
+    }
+
+    int nodeCount = thread.nodeCount.load(std::memory_order_acquire);
+    for (; thread.read < written; thread.read++)
+    {
+        const auto &event = thread.events[thread.read & (PROFILER_RING_SIZE - 1)];
+        if (event.node < nodeCount)
+        {
+            thread.stats[event.node].frameTime += event.end - event.start;
+            thread.stats[event.node].frameCalls++;
+            thread.stats[event.node].frameAllocations += event.allocations;
+            thread.stats[event.node].frameAllocBytes += event.allocBytes;
+
+            if (captureFramesLeft > 0)
+            {
+                if (captureEvents.size() < PROFILER_CAPTURE_MAX_EVENTS)
+                {
+                    captureEvents.push_back({thread.nodes[event.node].name, threadIndex, event.start, event.end});
+                }
+                else
+                {
+                    captureDropped++;
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < nodeCount; i++)
+    {
+        auto &stats = thread.stats[i];
+        stats.history[historyIndex] = stats.frameTime;
+        stats.calls = stats.frameCalls;
+        stats.frameTime = 0;
+        stats.frameCalls = 0;
+        stats.allocations = stats.frameAllocations;
+        stats.allocBytes = stats.frameAllocBytes;
+        stats.maxAllocations = stats.allocations > stats.maxAllocations ? stats.allocations : stats.maxAllocations;
+        stats.frameAllocations = 0;
+        stats.frameAllocBytes = 0;
+
+        uint64_t total = 0;
+        stats.max = 0;
+        for (auto time : stats.history)
+        {
+            total += time;
+            stats.max = time > stats.max ? time : stats.max;
+        }
+        stats.average = (double)total / PROFILER_HISTORY_FRAMES;
+    }
+}
+
+void Profiler::EndFrame()
+{
+    for (int i = 0; i < PROFILER_MAX_THREADS; i++)
+    {
+        if (threads[i].nodeCount.load(std::memory_order_acquire) > 0)
+        {
+            ConsumeEvents(threads[i], i);
+        }
+    }
+    historyIndex = (historyIndex + 1) % PROFILER_HISTORY_FRAMES;
+    Counters::EndFrame();
+
+    if (captureFramesLeft > 0)
+    {
+        captureFrames.push_back(Now());
+        captureFramesLeft--;
+        if (captureFramesLeft == 0)
+        {
+            WriteCapture();
+        }
+    }
+
+    if (IsKeyPressed(KEY_F4) && !IsCapturing())
+    {
+        StartCapture(PROFILER_CAPTURE_FRAMES);
+    }
+}
+
+void Profiler::StartCapture(int frames)
+{
+    if (frames <= 0)
+    {
+        return;
+    }
+    // Everything is allocated up front, the capture itself doesn't allocate
+    captureEvents.clear();
+    captureEvents.reserve(PROFILER_CAPTURE_MAX_EVENTS);
+    captureFrames.clear();
+    captureFrames.reserve(frames + 1);
+    captureFrames.push_back(Now());
+    captureFramesLeft = frames;
+    captureDropped = 0;
+}
+
+bool Profiler::IsCapturing()
+{
+    return captureFramesLeft > 0;
+}
+
+void Profiler::WriteCapture()
+{
+    FILE *file = fopen(PROFILER_CAPTURE_PATH, "w");
+    if (file == nullptr)
+    {
+        TraceLog(LOG_WARNING, "PROFILER: Could not write %s", PROFILER_CAPTURE_PATH);
+    }
+    else
+    {
+        uint64_t origin = captureFrames.front();
+        fprintf(file, "{\"traceEvents\":[\n");
+        fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"ludum_dare_55\"}}");
+
+        for (int i = 0; i < PROFILER_MAX_THREADS; i++)
+        {
+            if (threads[i].nodeCount.load(std::memory_order_acquire) > 0)
+            {
+                fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                        i, threads[i].name);
+            }
+        }
+
+        // Frame markers on the main thread, as global instant events
+        for (size_t i = 0; i + 1 < captureFrames.size(); i++)
+        {
+            fprintf(file, ",\n{\"name\":\"Frame %zu\",\"cat\":\"frame\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":%.3f}",
+                    i, (captureFrames[i] - origin) / 1000.0);
+        }
+
+        for (const auto &event : captureEvents)
+        {
+            // Zones that started before the capture are clamped to its start
+            uint64_t start = event.start > origin ? event.start : origin;
+            uint64_t end = event.end > start ? event.end : start;
+            fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"zone\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    event.name, event.thread, (start - origin) / 1000.0, (end - start) / 1000.0);
+        }
+
+        fprintf(file, "\n],\"otherData\":{\"droppedEvents\":%d}}\n", captureDropped);
+        fclose(file);
+        TraceLog(LOG_INFO, "PROFILER: Wrote %zu zones over %zu frames to %s",
+                 captureEvents.size(), captureFrames.size() - 1, PROFILER_CAPTURE_PATH);
+    }
+
+    // Give the memory back, captures are rare
+    std::vector<CaptureEvent>().swap(captureEvents);
+    std::vector<uint64_t>().swap(captureFrames);
+}
+
+void Profiler::DrawNode(ProfileThread &thread, int node, int nodeCount, int x, int &y)
+{
+    const auto &stats = thread.stats[node];
+    char line[64];
+    snprintf(line, sizeof(line), "%7.3f ms %7.3f ms %4d", stats.average / 1e6, stats.max / 1e6, stats.calls);
+    DrawText(thread.nodes[node].name, x + thread.nodes[node].depth * 10, y, 10, WHITE);
+    DrawText(line, x + 220, y, 10, WHITE);
+#if defined(ENABLE_ALLOC_TRACKING)
+    // Allocations in the last frame and the most in a frame, red when the zone allocates
+    snprintf(line, sizeof(line), "%5u %5u %8.1f KB", stats.allocations, stats.maxAllocations, stats.allocBytes / 1024.0);
+    DrawText(line, x + 410, y, 10, stats.allocations > 0 ? RED : WHITE);
+#endif
+    y += 12;
+
+    // Nodes added after the count was loaded show up in the next frame
+    for (int child = thread.nodes[node].firstChild.load(std::memory_order_acquire); child >= 0 && child < nodeCount;
+         child = thread.nodes[child].nextSibling.load(std::memory_order_acquire))
+    {
+        DrawNode(thread, child, nodeCount, x, y);
+    }
+}
+
+void Profiler::DrawOverlay()
+{
+    Counters::DrawOverlay();
+
+    if (IsKeyPressed(KEY_F3))
+    {
+        overlayVisible = !overlayVisible;
+    }
+    if (!overlayVisible)
+    {
+        return;
+    }
+
+    int y = 50;
+#if defined(ENABLE_ALLOC_TRACKING)
+    int width = 560;
+#else
+    int width = 420;
+#endif
+    DrawRectangle(5, y - 5, width, GetScreenHeight() - y - 10, Fade(BLACK, 0.75f));
+    if (IsCapturing())
+    {
+        DrawText(TextFormat("Capturing trace, %i frames left", captureFramesLeft), 10, y - 14, 10, RED);
+    }
+    DrawText("Zone", 10, y, 10, YELLOW);
+    DrawText("    avg         max     calls", 230, y, 10, YELLOW);
+#if defined(ENABLE_ALLOC_TRACKING)
+    DrawText("allocs   max       bytes", 420, y, 10, YELLOW);
+    auto frame = AllocTracker::GetLastFrame();
+    DrawText(TextFormat("Frame: %llu allocations, %.1f KB live (peak %.1f KB)",
+                        static_cast<unsigned long long>(frame.allocations), AllocTracker::GetLiveBytes() / 1024.0,
+                        AllocTracker::GetPeakLiveBytes() / 1024.0),
+             10, GetScreenHeight() - 28, 10, frame.allocations > 0 ? RED : GREEN);
+#endif
+    y += 14;
+
+    for (auto &thread : threads)
+    {
+        int nodeCount = thread.nodeCount.load(std::memory_order_acquire);
+        if (nodeCount == 0)
+        {
+            continue;
+        }
+
+        DrawText(thread.name, 10, y, 10, GREEN);
+        y += 12;
+        for (int root = thread.firstRoot.load(std::memory_order_acquire); root >= 0 && root < nodeCount;
+             root = thread.nodes[root].nextSibling.load(std::memory_order_acquire))
+        {
+            DrawNode(thread, root, nodeCount, 10, y);
+        }
+    }
+}
+
+#endif // ENABLE_PROFILER
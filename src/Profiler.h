@@ -0,0 +1,154 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Scoped CPU profiler. Only compiled in when ENABLE_PROFILER is defined (make PROFILE=1),
+// otherwise every macro expands to nothing.
+//
+//   PROFILE_SCOPE("UpdateWorld");   // times the enclosing scope
+//   PROFILE_THREAD("Audio");        // names the calling thread in the overlay
+//   PROFILE_FRAME();                // end of frame, once per frame on the main thread
+//   PROFILE_OVERLAY();              // draws the overlay (toggled with F3) and the counters (F5)
+//
+// F4 (or --trace N on the command line) captures the next frames into a Chrome trace_event
+// file, open it in Perfetto or chrome://tracing.
+// Built with the allocation tracker as well (make PROFILE=1 ALLOC_TRACKING=1), the overlay
+// shows the heap allocations made in every zone, see src/AllocTracker.h.
+
+#if defined(ENABLE_PROFILER)
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+inline constexpr int PROFILER_MAX_THREADS = 8;
+inline constexpr int PROFILER_MAX_NODES = 256;
+inline constexpr int PROFILER_MAX_DEPTH = 32;
+inline constexpr int PROFILER_RING_SIZE = 16384; // Power of 2
+inline constexpr int PROFILER_HISTORY_FRAMES = 120;
+inline constexpr int PROFILER_CAPTURE_FRAMES = 300;
+inline constexpr int PROFILER_CAPTURE_MAX_EVENTS = 1 << 18; // Bounds the capture to ~6MB
+inline constexpr const char *PROFILER_CAPTURE_PATH = "trace.json";
+
+// Zone in the call tree of a thread, created the first time a scope is entered from a parent.
+// The links are read by the overlay while the thread adds nodes, a node is filled in before
+// the link to it is published
+struct ProfileNode
+{
+    const char *name;
+    int parent;
+    int depth;
+    std::atomic<int> firstChild;
+    std::atomic<int> nextSibling;
+};
+
+// Scope timed on a thread, written when the scope ends
+struct ProfileEvent
+{
+    int node;
+    uint64_t start;
+    uint64_t end;
+    uint32_t allocations; // Made on the thread inside the scope, children included
+    uint64_t allocBytes;
+};
+
+// Rolling stats of a node, only touched by the main thread
+struct ProfileStats
+{
+    uint64_t frameTime;
+    int frameCalls;
+    uint64_t history[PROFILER_HISTORY_FRAMES];
+    double average;
+    uint64_t max;
+    int calls;
+    uint32_t frameAllocations;
+    uint64_t frameAllocBytes;
+    uint32_t allocations; // Last frame
+    uint64_t allocBytes;
+    uint32_t maxAllocations; // Most in a frame since the zone was first entered
+};
+
+// Each thread only writes its own ring, the main thread reads up to `written` at the end
+// of every frame. Nodes are appended before the events using them are published
+struct ProfileThread
+{
+    char name[32];
+    std::atomic<bool> inUse{false};
+
+    ProfileNode nodes[PROFILER_MAX_NODES];
+    std::atomic<int> nodeCount{0};
+    std::atomic<int> firstRoot{-1};
+    int stack[PROFILER_MAX_DEPTH];
+    uint64_t stackStart[PROFILER_MAX_DEPTH];
+    uint64_t stackAllocations[PROFILER_MAX_DEPTH];
+    uint64_t stackAllocBytes[PROFILER_MAX_DEPTH];
+    int depth = 0;
+
+    ProfileEvent events[PROFILER_RING_SIZE];
+    std::atomic<uint64_t> written{0};
+    uint64_t read = 0;
+
+    ProfileStats stats[PROFILER_MAX_NODES];
+};
+
+// Zone kept for the trace, the name is the string literal given to PROFILE_SCOPE
+struct CaptureEvent
+{
+    const char *name;
+    int thread;
+    uint64_t start;
+    uint64_t end;
+};
+
+class Profiler
+{
+private:
+    inline static ProfileThread threads[PROFILER_MAX_THREADS];
+    inline static int historyIndex = 0;
+    inline static bool overlayVisible = false;
+
+    inline static std::vector<CaptureEvent> captureEvents;
+    inline static std::vector<uint64_t> captureFrames;
+    inline static int captureFramesLeft = 0;
+    inline static int captureDropped = 0;
+
+    static ProfileThread *GetThread();
+    static void ConsumeEvents(ProfileThread &thread, int threadIndex);
+    static void WriteCapture();
+    static void DrawNode(ProfileThread &thread, int node, int nodeCount, int x, int &y);
+
+public:
+    static uint64_t Now();
+    static void SetThreadName(const char *name);
+    static void BeginScope(const char *name);
+    static void EndScope();
+    static void EndFrame();
+    static void DrawOverlay();
+    static void StartCapture(int frames);
+    static bool IsCapturing();
+};
+
+struct ProfileScope
+{
+    ProfileScope(const char *name) { Profiler::BeginScope(name); }
+    ~ProfileScope() { Profiler::EndScope(); }
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_THREAD(name) Profiler::SetThreadName(name)
+#define PROFILE_FRAME() Profiler::EndFrame()
+#define PROFILE_OVERLAY() Profiler::DrawOverlay()
+#define PROFILE_CAPTURE(frames) Profiler::StartCapture(frames)
+
+#else
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_THREAD(name)
+#define PROFILE_FRAME()
+#define PROFILE_OVERLAY()
+#define PROFILE_CAPTURE(frames)
+
+#endif // ENABLE_PROFILER
+
+#endif // PROFILER_H
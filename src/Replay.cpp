@@ -0,0 +1,303 @@
+#include "Replay.h"
+#include <cstdio>
+#include <random>
+
+// Every step takes one byte: the move axes (-1, 0, 1 stored as 0, 1, 2), interact and whether
+// the pointer moved. A moved pointer is followed by its two floats
+inline constexpr uint8_t REPLAY_INTERACT = 1 << 4;
+inline constexpr uint8_t REPLAY_POINTER = 1 << 5;
+
+struct ReplayHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t level;
+    uint32_t seed;
+    float timestep;
+    uint32_t steps;
+    uint32_t hashes;
+};
+
+static uint8_t EncodeAxis(float value)
+{
+    return value < -0.5f ? 0 : (value > 0.5f ? 2 : 1);
+}
+
+bool SaveReplay(const std::string &path, const Replay &replay)
+{
+    FILE *file = fopen(path.c_str(), "wb");
+    if (file == nullptr)
+    {
+        TraceLog(LOG_WARNING, "REPLAY: Could not write %s", path.c_str());
+        return false;
+    }
+
+    ReplayHeader header = {REPLAY_MAGIC, REPLAY_VERSION, static_cast<uint16_t>(replay.level), replay.seed,
+                           replay.timestep, static_cast<uint32_t>(replay.inputs.size()),
+                           static_cast<uint32_t>(replay.hashes.size())};
+    fwrite(&header, sizeof(header), 1, file);
+    uint32_t tileStateBits = replay.tileStateBits;
+    fwrite(&tileStateBits, sizeof(tileStateBits), 1, file);
+
+    Vector2 pointer = {0, 0};
+    for (const auto &input : replay.inputs)
+    {
+        uint8_t flags = EncodeAxis(input.move.x) | (EncodeAxis(input.move.y) << 2);
+        if (input.interact)
+        {
+            flags |= REPLAY_INTERACT;
+        }
+        bool pointerMoved = input.pointer.x != pointer.x || input.pointer.y != pointer.y;
+        if (pointerMoved)
+        {
+            flags |= REPLAY_POINTER;
+        }
+
+        fwrite(&flags, 1, 1, file);
+        if (pointerMoved)
+        {
+            fwrite(&input.pointer.x, sizeof(float), 1, file);
+            fwrite(&input.pointer.y, sizeof(float), 1, file);
+            pointer = input.pointer;
+        }
+    }
+
+    fwrite(replay.hashes.data(), sizeof(uint64_t), replay.hashes.size(), file);
+    bool written = ferror(file) == 0;
+    fclose(file);
+    return written;
+}
+
+bool LoadReplay(const std::string &path, Replay &replay)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == nullptr)
+    {
+        TraceLog(LOG_WARNING, "REPLAY: Could not open %s", path.c_str());
+        return false;
+    }
+
+    ReplayHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != REPLAY_MAGIC || header.version < 1 ||
+        header.version > REPLAY_VERSION)
+    {
+        TraceLog(LOG_WARNING, "REPLAY: %s is not a replay of this version", path.c_str());
+        fclose(file);
+        return false;
+    }
+    // Version 1 was recorded before the tile states could be quantized
+    uint32_t tileStateBits = 32;
+    if (header.version >= 2 && fread(&tileStateBits, sizeof(tileStateBits), 1, file) != 1)
+    {
+        TraceLog(LOG_WARNING, "REPLAY: %s is truncated", path.c_str());
+        fclose(file);
+        return false;
+    }
+    if (tileStateBits != REPLAY_TILE_STATE_BITS)
+    {
+        TraceLog(LOG_WARNING, "REPLAY: %s was recorded with %u bit tile states, this build uses %d (TILE_STATE_BITS)",
+                 path.c_str(), tileStateBits, REPLAY_TILE_STATE_BITS);
+        fclose(file);
+        return false;
+    }
+
+    replay.level = header.level;
+    replay.seed = header.seed;
+    replay.timestep = header.timestep;
+    replay.tileStateBits = static_cast<int>(tileStateBits);
+    replay.inputs.assign(header.steps, WorldInput{});
+    replay.hashes.assign(header.hashes, 0);
+
+    bool valid = true;
+    Vector2 pointer = {0, 0};
+    for (auto &input : replay.inputs)
+    {
+        uint8_t flags = 0;
+        if (fread(&flags, 1, 1, file) != 1)
+        {
+            valid = false;
+            break;
+        }
+        input.move = Vector2{static_cast<float>(flags & 3) - 1.0f, static_cast<float>((flags >> 2) & 3) - 1.0f};
+        input.interact = (flags & REPLAY_INTERACT) != 0;
+        if (flags & REPLAY_POINTER)
+        {
+            valid = fread(&pointer.x, sizeof(float), 1, file) == 1 && fread(&pointer.y, sizeof(float), 1, file) == 1;
+            if (!valid)
+            {
+                break;
+            }
+        }
+        input.pointer = pointer;
+    }
+
+    valid = valid && fread(replay.hashes.data(), sizeof(uint64_t), replay.hashes.size(), file) == replay.hashes.size();
+    fclose(file);
+    if (!valid)
+    {
+        TraceLog(LOG_WARNING, "REPLAY: %s is truncated", path.c_str());
+    }
+    return valid;
+}
+
+bool GetReplayHash(const Replay &replay, size_t step, uint64_t &hash)
+{
+    size_t index;
+    if (step + 1 == replay.inputs.size())
+    {
+        index = replay.hashes.size() - 1;
+    }
+    else if ((step + 1) % REPLAY_HASH_INTERVAL == 0)
+    {
+        index = (step + 1) / REPLAY_HASH_INTERVAL - 1;
+    }
+    else
+    {
+        return false;
+    }
+
+    if (index >= replay.hashes.size())
+    {
+        return false;
+    }
+    hash = replay.hashes[index];
+    return true;
+}
+
+void Replays::RecordTo(const std::string &path)
+{
+    recordPath = path;
+    recording = true;
+}
+
+bool Replays::PlayFrom(const std::string &path)
+{
+    playback = LoadReplay(path, replay);
+    if (playback)
+    {
+        TraceLog(LOG_INFO, "REPLAY: Loaded %zu steps of level %d from %s", replay.inputs.size(), replay.level, path.c_str());
+    }
+    return playback;
+}
+
+void Replays::Begin(World *world)
+{
+    End(nullptr);
+    step = 0;
+    divergedStep = -1;
+
+    if (playback)
+    {
+        if (world->currentLevel != replay.level || replay.timestep != WORLD_TIMESTEP)
+        {
+            TraceLog(LOG_WARNING, "REPLAY: The replay is for level %d, not played back", replay.level);
+            return;
+        }
+        if (replay.tileStateBits != REPLAY_TILE_STATE_BITS)
+        {
+            TraceLog(LOG_WARNING, "REPLAY: The replay has %d bit tile states, this build %d, not played back",
+                     replay.tileStateBits, REPLAY_TILE_STATE_BITS);
+            return;
+        }
+        SeedWorld(world, replay.seed);
+        active = true;
+    }
+    else if (recording)
+    {
+        replay = Replay{};
+        replay.level = world->currentLevel;
+        replay.seed = std::random_device{}();
+        SeedWorld(world, replay.seed);
+        active = true;
+    }
+}
+
+WorldInput Replays::NextInput(World *world, const WorldInput &live)
+{
+    if (active && playback)
+    {
+        return step < replay.inputs.size() ? replay.inputs[step] : WorldInput{};
+    }
+    return live;
+}
+
+void Replays::AfterStep(const World *world, const WorldInput &input)
+{
+    if (!active)
+    {
+        return;
+    }
+
+    bool lastStep = playback && step + 1 == replay.inputs.size();
+    if (recording && !playback)
+    {
+        replay.inputs.push_back(input);
+        if (replay.inputs.size() % REPLAY_HASH_INTERVAL == 0)
+        {
+            replay.hashes.push_back(HashWorld(world));
+        }
+    }
+    else
+    {
+        uint64_t expected = 0;
+        if (divergedStep < 0 && GetReplayHash(replay, step, expected) && expected != HashWorld(world))
+        {
+            divergedStep = static_cast<long>(step);
+        }
+    }
+    step++;
+
+    if (lastStep)
+    {
+        End(world);
+    }
+}
+
+void Replays::End(const World *world)
+{
+    if (!active)
+    {
+        return;
+    }
+    active = false;
+
+    if (playback)
+    {
+        if (divergedStep >= 0)
+        {
+            TraceLog(LOG_WARNING, "REPLAY: Diverged from the recording, detected at step %ld", divergedStep + 1);
+        }
+        else if (step < replay.inputs.size())
+        {
+            TraceLog(LOG_INFO, "REPLAY: Stopped after %zu of %zu steps, no divergence so far", step, replay.inputs.size());
+        }
+        else
+        {
+            TraceLog(LOG_INFO, "REPLAY: %zu steps played back, the world matches the recording", step);
+        }
+        // The rest of the session is played by hand
+        playback = false;
+        return;
+    }
+
+    if (replay.inputs.size() % REPLAY_HASH_INTERVAL != 0)
+    {
+        if (world != nullptr)
+        {
+            replay.hashes.push_back(HashWorld(world));
+        }
+        else
+        {
+            // Without the world the last steps can't be checked, they are left out
+            replay.inputs.resize(replay.hashes.size() * REPLAY_HASH_INTERVAL);
+        }
+    }
+    if (replay.inputs.empty())
+    {
+        return;
+    }
+    if (SaveReplay(recordPath, replay))
+    {
+        TraceLog(LOG_INFO, "REPLAY: Recorded %zu steps of level %d to %s", replay.inputs.size(), replay.level, recordPath.c_str());
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "world.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Recording of a play session: the level, the seed and the input of every fixed step.
+// Stepping a world created from the same level and seed with the same inputs gives the
+// same state, the hashes taken while recording check it.
+//
+//   ludum_dare_55 --record session.replay   // the last attempt played is saved
+//   ludum_dare_55 --replay session.replay   // plays it back in the window
+//   bench_world --replay session.replay     // plays it back headless and times it
+
+inline constexpr uint32_t REPLAY_MAGIC = 0x50524C44; // "LDRP"
+inline constexpr uint16_t REPLAY_VERSION = 2; // 2 stores the tile state bits, 1 was float only
+inline constexpr int REPLAY_HASH_INTERVAL = 60; // Steps between two world hashes
+// Bits of the tile states of this build (see TileState.h), the hashes only match with the same
+inline constexpr int REPLAY_TILE_STATE_BITS = sizeof(TileState) * 8;
+
+struct Replay
+{
+    int level = 1;
+    uint32_t seed = 0;
+    float timestep = WORLD_TIMESTEP;
+    int tileStateBits = REPLAY_TILE_STATE_BITS;
+    std::vector<WorldInput> inputs;
+    // HashWorld after every REPLAY_HASH_INTERVAL steps, and after the last one
+    std::vector<uint64_t> hashes;
+};
+
+bool SaveReplay(const std::string &path, const Replay &replay);
+bool LoadReplay(const std::string &path, Replay &replay);
+
+// Hash expected after a step (0 based), or false if none was stored for it
+bool GetReplayHash(const Replay &replay, size_t step, uint64_t &hash);
+
+// Records or plays back the sessions of the game, set up from the command line
+class Replays
+{
+private:
+    inline static std::string recordPath;
+    inline static bool recording = false;
+    inline static bool playback = false;
+    inline static bool active = false;
+    inline static Replay replay;
+    inline static size_t step = 0;
+    inline static long divergedStep = -1;
+
+public:
+    static void RecordTo(const std::string &path);
+    static bool PlayFrom(const std::string &path);
+    static bool IsPlayingBack() { return playback; }
+    static int GetPlaybackLevel() { return replay.level; }
+
+    // A fresh world starts playing: seeds it and starts recording or playing back
+    static void Begin(World *world);
+    // Input of the next step, from the replay or from the player
+    static WorldInput NextInput(World *world, const WorldInput &live);
+    // Records the step that just ran, or checks it against the replay
+    static void AfterStep(const World *world, const WorldInput &input);
+    // The world stopped playing: saves the recording or reports the playback result.
+    // The world gives the final hash, without it the steps after the last hash are dropped
+    static void End(const World *world);
+};
+
+#endif // REPLAY_H
@@ -0,0 +1,361 @@
+#include "Rewind.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <type_traits>
+#include "Profiler.h"
+
+static_assert(std::is_trivially_copyable_v<Elemental>, "Elementals are stored as plain bytes");
+static_assert(std::is_trivially_copyable_v<TileType>);
+
+// Longest literal of a delta, its length is stored in one byte
+inline constexpr int DELTA_MAX_LITERAL = 255;
+
+static void WriteVarint(std::vector<uint8_t> &out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+static uint64_t ReadVarint(const uint8_t *&cursor, const uint8_t *end)
+{
+    uint64_t value = 0;
+    for (int shift = 0; cursor < end; shift += 7)
+    {
+        uint8_t byte = *cursor++;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            break;
+        }
+    }
+    return value;
+}
+
+// Writes the xor of two byte ranges as (zero bytes to skip, literal length, literal bytes)
+// tokens. The ranges given one after the other form a single stream, the zeros at its end
+// are left out
+class DeltaWriter
+{
+private:
+    std::vector<uint8_t> &out;
+    uint64_t zeros = 0;
+    size_t literalLength = 0; // Index of the length byte of the open literal, 0 when closed
+
+public:
+    explicit DeltaWriter(std::vector<uint8_t> &out) : out(out) {}
+
+    void Write(const void *previous, const void *current, size_t size)
+    {
+        auto a = static_cast<const uint8_t *>(previous);
+        auto b = static_cast<const uint8_t *>(current);
+        for (size_t i = 0; i < size; i++)
+        {
+            uint8_t delta = a[i] ^ b[i];
+            if (delta == 0)
+            {
+                literalLength = 0;
+                zeros++;
+                continue;
+            }
+            if (literalLength == 0)
+            {
+                WriteVarint(out, zeros);
+                zeros = 0;
+                literalLength = out.size();
+                out.push_back(0);
+            }
+            out.push_back(delta);
+            if (++out[literalLength] == DELTA_MAX_LITERAL)
+            {
+                literalLength = 0;
+            }
+        }
+    }
+};
+
+// Applies a stream written by DeltaWriter, xoring it into the same ranges in the same order
+class DeltaReader
+{
+private:
+    const uint8_t *cursor;
+    const uint8_t *end;
+    uint64_t zeros = 0;
+    int literal = 0;
+
+public:
+    DeltaReader(const uint8_t *data, size_t size) : cursor(data), end(data + size) {}
+
+    void Apply(void *target, size_t size)
+    {
+        auto bytes = static_cast<uint8_t *>(target);
+        size_t i = 0;
+        while (i < size)
+        {
+            if (zeros > 0)
+            {
+                uint64_t skip = std::min<uint64_t>(zeros, size - i);
+                i += skip;
+                zeros -= skip;
+            }
+            else if (literal > 0)
+            {
+                bytes[i++] ^= *cursor++;
+                literal--;
+            }
+            else if (cursor < end)
+            {
+                zeros = ReadVarint(cursor, end);
+                literal = cursor < end ? *cursor++ : 0;
+            }
+            else
+            {
+                // Only unchanged bytes left
+                return;
+            }
+        }
+    }
+};
+
+WorldHistory::WorldHistory(size_t bufferSize, int maxSteps) : buffer(bufferSize), records(maxSteps)
+{
+}
+
+void WorldHistory::Reset()
+{
+    head = 0;
+    usedBytes = 0;
+    firstRecord = 0;
+    recordCount = 0;
+    hasBase = false;
+}
+
+void WorldHistory::ReadScalars(const World *world, WorldScalars &read) const
+{
+    // Padding included, so equal states give equal bytes
+    memset(static_cast<void *>(&read), 0, sizeof(read));
+    read.player = world->player;
+    read.input = world->input;
+    read.camera = world->camera;
+    read.random = world->random;
+    read.elementalPower = world->elementalPower;
+    read.elementalRange = world->elementalRange;
+    read.springTiles = world->springTiles;
+    read.springDominance = world->springDominance;
+    read.firstTileComputed = world->firstTileComputed;
+    read.grabbingFireStaff = world->grabbingFireStaff;
+    read.grabbingIceStaff = world->grabbingIceStaff;
+    read.wasInVictory = world->wasInVictory;
+    read.gemPosition = world->gemPosition;
+    read.timeInVictory = world->timeInVictory;
+    read.hitEmitter = world->hitEmitter;
+    read.healEmitter = world->healEmitter;
+}
+
+void WorldHistory::TakeBase(World *world)
+{
+    Reset();
+    hasBase = true;
+    level = world->currentLevel;
+    width = world->width;
+    height = world->height;
+
+    size_t area = static_cast<size_t>(width) * height;
+    tileStates.resize(area);
+    tileTypes.resize(area);
+    for (int y = 0; y < height; y++)
+    {
+        std::copy(world->tileStates[y].begin(), world->tileStates[y].end(), tileStates.begin() + static_cast<size_t>(y) * width);
+        std::copy(world->tileTypes[y].begin(), world->tileTypes[y].end(), tileTypes.begin() + static_cast<size_t>(y) * width);
+    }
+    elementals.assign(world->elementals.begin(), world->elementals.end());
+    ReadScalars(world, scalars);
+    ClearDirtyChunks(world);
+}
+
+void WorldHistory::Record(World *world)
+{
+    PROFILE_SCOPE("WorldHistory::Record");
+    if (!hasBase || world->currentLevel != level || world->width != width || world->height != height ||
+        world->elementals.size() != elementals.size())
+    {
+        TakeBase(world);
+        return;
+    }
+
+    chunks.clear();
+    for (size_t word = 0; word < world->dirtyChunks.size(); word++)
+    {
+        for (uint64_t bits = world->dirtyChunks[word]; bits != 0; bits &= bits - 1)
+        {
+            chunks.push_back(static_cast<int>(word * 64 + std::countr_zero(bits)));
+        }
+    }
+
+    // Header: the changed chunks, as gaps from the previous one
+    encoded.clear();
+    WriteVarint(encoded, chunks.size());
+    int lastChunk = 0;
+    for (int chunk : chunks)
+    {
+        WriteVarint(encoded, chunk - lastChunk);
+        lastChunk = chunk;
+    }
+
+    DeltaWriter writer(encoded);
+    WorldScalars current;
+    ReadScalars(world, current);
+    writer.Write(&scalars, &current, sizeof(WorldScalars));
+    memcpy(static_cast<void *>(&scalars), &current, sizeof(WorldScalars));
+
+    writer.Write(elementals.data(), world->elementals.data(), elementals.size() * sizeof(Elemental));
+    std::copy(world->elementals.begin(), world->elementals.end(), elementals.begin());
+
+    for (int chunk : chunks)
+    {
+        int minX = chunk % world->chunksX * WORLD_CHUNK_SIZE;
+        int minY = chunk / world->chunksX * WORLD_CHUNK_SIZE;
+        int maxX = std::min(minX + WORLD_CHUNK_SIZE, width);
+        int maxY = std::min(minY + WORLD_CHUNK_SIZE, height);
+        for (int y = minY; y < maxY; y++)
+        {
+            size_t row = static_cast<size_t>(y) * width;
+            int count = maxX - minX;
+            writer.Write(&tileStates[row + minX], &world->tileStates[y][minX], count * sizeof(TileState));
+            writer.Write(&tileTypes[row + minX], &world->tileTypes[y][minX], count * sizeof(TileType));
+            std::copy_n(&world->tileStates[y][minX], count, &tileStates[row + minX]);
+            std::copy_n(&world->tileTypes[y][minX], count, &tileTypes[row + minX]);
+        }
+    }
+    ClearDirtyChunks(world);
+
+    Push(encoded);
+}
+
+void WorldHistory::Push(const std::vector<uint8_t> &record)
+{
+    if (record.size() > buffer.size())
+    {
+        // Can't go back past this step
+        head = 0;
+        usedBytes = 0;
+        firstRecord = 0;
+        recordCount = 0;
+        return;
+    }
+
+    if (head + record.size() > buffer.size())
+    {
+        // The end of the buffer stays unused, the records after the head there are the oldest
+        while (recordCount > 0 && records[firstRecord].offset >= head)
+        {
+            DropOldest();
+        }
+        head = 0;
+    }
+    // Drop the oldest records in the way, and the oldest one when the index is full
+    while (recordCount > 0)
+    {
+        const auto &oldest = records[firstRecord];
+        bool overlaps = oldest.offset < head + record.size() && oldest.offset + oldest.size > head;
+        if (!overlaps && recordCount < static_cast<int>(records.size()))
+        {
+            break;
+        }
+        DropOldest();
+    }
+
+    memcpy(buffer.data() + head, record.data(), record.size());
+    records[(firstRecord + recordCount) % records.size()] = {head, record.size()};
+    recordCount++;
+    head += record.size();
+    usedBytes += record.size();
+}
+
+void WorldHistory::DropOldest()
+{
+    usedBytes -= records[firstRecord].size;
+    firstRecord = (firstRecord + 1) % records.size();
+    recordCount--;
+}
+
+bool WorldHistory::Rewind(World *world)
+{
+    PROFILE_SCOPE("WorldHistory::Rewind");
+    if (recordCount == 0 || !hasBase || world->currentLevel != level)
+    {
+        return false;
+    }
+
+    const auto &record = records[(firstRecord + recordCount - 1) % records.size()];
+    const uint8_t *cursor = buffer.data() + record.offset;
+    const uint8_t *end = cursor + record.size;
+
+    chunks.resize(ReadVarint(cursor, end));
+    int lastChunk = 0;
+    for (auto &chunk : chunks)
+    {
+        chunk = lastChunk + static_cast<int>(ReadVarint(cursor, end));
+        lastChunk = chunk;
+    }
+
+    DeltaReader reader(cursor, end - cursor);
+    reader.Apply(&scalars, sizeof(WorldScalars));
+    reader.Apply(elementals.data(), elementals.size() * sizeof(Elemental));
+
+    for (int chunk : chunks)
+    {
+        int minX = chunk % world->chunksX * WORLD_CHUNK_SIZE;
+        int minY = chunk / world->chunksX * WORLD_CHUNK_SIZE;
+        int maxX = std::min(minX + WORLD_CHUNK_SIZE, width);
+        int maxY = std::min(minY + WORLD_CHUNK_SIZE, height);
+        for (int y = minY; y < maxY; y++)
+        {
+            size_t row = static_cast<size_t>(y) * width;
+            int count = maxX - minX;
+            reader.Apply(&tileStates[row + minX], count * sizeof(TileState));
+            reader.Apply(&tileTypes[row + minX], count * sizeof(TileType));
+            for (int x = minX; x < maxX; x++)
+            {
+                TileType type = tileTypes[row + x];
+                world->tileStates[y][x] = tileStates[row + x];
+                world->tileTypes[y][x] = type;
+                // The colors follow the types, only blocks keep their own
+                if (type != TileType::Block)
+                {
+                    world->tiles[y][x] = GetTileColor(type);
+                }
+            }
+        }
+    }
+
+    std::copy(elementals.begin(), elementals.end(), world->elementals.begin());
+    world->player = scalars.player;
+    world->input = scalars.input;
+    world->camera = scalars.camera;
+    world->random = scalars.random;
+    world->elementalPower = scalars.elementalPower;
+    world->elementalRange = scalars.elementalRange;
+    world->springTiles = scalars.springTiles;
+    world->springDominance = scalars.springDominance;
+    world->firstTileComputed = scalars.firstTileComputed;
+    world->grabbingFireStaff = scalars.grabbingFireStaff;
+    world->grabbingIceStaff = scalars.grabbingIceStaff;
+    world->wasInVictory = scalars.wasInVictory;
+    world->gemPosition = scalars.gemPosition;
+    world->timeInVictory = scalars.timeInVictory;
+    world->hitEmitter = scalars.hitEmitter;
+    world->healEmitter = scalars.healEmitter;
+    world->particleSystem.Clear();
+    ClearDirtyChunks(world);
+
+    // The newest record goes away, its space is written again first
+    head = record.offset;
+    usedBytes -= record.size;
+    recordCount--;
+    return true;
+}
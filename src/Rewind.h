@@ -0,0 +1,93 @@
+#ifndef REWIND_H
+#define REWIND_H
+
+#include "world.h"
+#include <cstdint>
+#include <random>
+#include <vector>
+
+inline constexpr size_t REWIND_BUFFER_SIZE = 4 * 1024 * 1024;
+inline constexpr int REWIND_MAX_STEPS = 60 * 60 * 5; // Five minutes of fixed steps
+inline constexpr int REWIND_STEPS_PER_FRAME = 2;     // Rewinding plays at twice the speed
+
+// History of a world kept to play it backwards. Every step stores how to go from the new state
+// back to the previous one: the bytes that changed (xor with the previous state) with the
+// runs of unchanged bytes left out. Only the chunks of tiles the elementals touched are
+// compared, so the cost of a step doesn't grow with the size of the level.
+// The records go in a ring buffer of fixed size, the oldest ones are dropped to make room.
+// Particles and events are not part of the history, rewinding clears the particles.
+//
+//   history.Record(world);   // after every UpdateWorld
+//   history.Rewind(world);   // one step back, instead of stepping
+//   history.Reset();         // when the world is replaced or restored
+class WorldHistory
+{
+private:
+    // Everything of the world but the tiles and the elementals, compared as plain bytes
+    struct WorldScalars
+    {
+        Player player;
+        WorldInput input;
+        Camera2D camera;
+        std::mt19937 random;
+        float elementalPower;
+        int elementalRange;
+        int springTiles;
+        float springDominance;
+        bool firstTileComputed;
+        bool grabbingFireStaff;
+        bool grabbingIceStaff;
+        bool wasInVictory;
+        Vector2 gemPosition;
+        float timeInVictory;
+        ParticleEmitter hitEmitter;
+        ParticleEmitter healEmitter;
+    };
+
+    struct StepRecord
+    {
+        size_t offset;
+        size_t size;
+    };
+
+    std::vector<uint8_t> buffer;
+    size_t head = 0;
+    size_t usedBytes = 0;
+    std::vector<StepRecord> records;
+    int firstRecord = 0;
+    int recordCount = 0;
+
+    // State of the world at the last Record, the records go back from it
+    bool hasBase = false;
+    int level = 0;
+    int width = 0;
+    int height = 0;
+    std::vector<TileState> tileStates;
+    std::vector<TileType> tileTypes;
+    std::vector<Elemental> elementals;
+    WorldScalars scalars;
+
+    std::vector<uint8_t> encoded;
+    std::vector<int> chunks;
+
+    void TakeBase(World *world);
+    void ReadScalars(const World *world, WorldScalars &read) const;
+    void Push(const std::vector<uint8_t> &record);
+    void DropOldest();
+
+public:
+    explicit WorldHistory(size_t bufferSize = REWIND_BUFFER_SIZE, int maxSteps = REWIND_MAX_STEPS);
+
+    // Forgets the history, the next Record starts it again
+    void Reset();
+    // Call after every step. The first call after a Reset only remembers the state
+    void Record(World *world);
+    // Takes the world back one step, false when there is no history left.
+    // The world must be in the state of the last Record
+    bool Rewind(World *world);
+
+    int GetSteps() const { return recordCount; }
+    size_t GetBytes() const { return usedBytes; }
+};
+
+#endif // REWIND_H
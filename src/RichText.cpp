@@ -0,0 +1,143 @@
+#include "RichText.h"
+#include <cstring>
+#include <cstdlib>
+
+static bool SameColor(Color a, Color b)
+{
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+// Parses "r,g,b,a" up to the end of the tag
+static Color ParseColorTag(const char *start)
+{
+    unsigned char values[4] = {0, 0, 0, 0};
+    char *end = const_cast<char *>(start);
+    for (int i = 0; i < 4; i++)
+    {
+        values[i] = static_cast<unsigned char>(strtol(end, &end, 10));
+        if (*end != ',')
+        {
+            break;
+        }
+        end++;
+    }
+    return {values[0], values[1], values[2], values[3]};
+}
+
+void RichText::Build(RichTextLayout &layout, const char *text, int fontSize, Color defaultColor)
+{
+    layout.key = text;
+    layout.source = text;
+    layout.fontSize = fontSize;
+    layout.defaultColor = defaultColor;
+    layout.text.clear();
+    layout.runs.clear();
+    layout.width = 0;
+
+    Color currentColor = defaultColor;
+    const char *start = text;
+
+    auto addRun = [&](const char *end) {
+        if (end == start)
+        {
+            return;
+        }
+        int offset = static_cast<int>(layout.text.size());
+        layout.text.append(start, end);
+        layout.text.push_back('\0');
+        layout.runs.push_back({offset, layout.width, currentColor});
+        layout.width += MeasureText(layout.text.c_str() + offset, fontSize);
+    };
+
+    while (*start != '\0')
+    {
+        const char *openTag = strstr(start, "<color=");
+        const char *closeTag = strstr(start, "</color>");
+
+        if (openTag != nullptr && (closeTag == nullptr || openTag < closeTag))
+        {
+            addRun(openTag);
+
+            const char *closeBracket = strchr(openTag, '>');
+            if (closeBracket == nullptr)
+            {
+                // Malformed tag
+                break;
+            }
+            currentColor = ParseColorTag(openTag + 7);
+            start = closeBracket + 1;
+        }
+        else if (closeTag != nullptr)
+        {
+            addRun(closeTag);
+            currentColor = defaultColor;
+            start = closeTag + 8;
+        }
+        else
+        {
+            // No more tags, the rest of the text is the last run
+            addRun(start + strlen(start));
+            break;
+        }
+    }
+}
+
+const RichTextLayout &RichText::GetLayout(const char *text, int fontSize, Color defaultColor)
+{
+    useCounter++;
+
+    RichTextLayout *oldest = &layouts[0];
+    for (auto &layout : layouts)
+    {
+        if (layout.key == text && layout.fontSize == fontSize && SameColor(layout.defaultColor, defaultColor))
+        {
+            if (layout.source != text)
+            {
+                Build(layout, text, fontSize, defaultColor);
+            }
+            layout.lastUsed = useCounter;
+            return layout;
+        }
+        if (layout.lastUsed < oldest->lastUsed)
+        {
+            oldest = &layout;
+        }
+    }
+
+    Build(*oldest, text, fontSize, defaultColor);
+    oldest->lastUsed = useCounter;
+    return *oldest;
+}
+
+void RichText::Clear()
+{
+    for (auto &layout : layouts)
+    {
+        layout = RichTextLayout{};
+    }
+    useCounter = 0;
+}
+
+static void DrawLayout(const RichTextLayout &layout, int posX, int posY)
+{
+    for (const auto &run : layout.runs)
+    {
+        DrawText(layout.text.c_str() + run.offset, posX + run.x, posY, layout.fontSize, run.color);
+    }
+}
+
+void DrawRichText(const char *text, int posX, int posY, int fontSize, Color defaultColor)
+{
+    DrawLayout(RichText::GetLayout(text, fontSize, defaultColor), posX, posY);
+}
+
+void DrawRichTextCentered(const char *text, int centerX, int posY, int fontSize, Color defaultColor)
+{
+    const auto &layout = RichText::GetLayout(text, fontSize, defaultColor);
+    DrawLayout(layout, centerX - layout.width / 2, posY);
+}
+
+int MeasureRichText(const char *text, int fontSize)
+{
+    return RichText::GetLayout(text, fontSize, WHITE).width;
+}
@@ -0,0 +1,52 @@
+#ifndef RICHTEXT_H
+#define RICHTEXT_H
+
+#include "raylib.h"
+#include <string>
+#include <vector>
+
+inline constexpr int RICH_TEXT_CACHE_SIZE = 64;
+
+// Piece of text drawn with a single color, offset from the start of the line
+struct RichTextRun
+{
+    int offset; // Into RichTextLayout::text
+    int x;
+    Color color;
+};
+
+// Parsed <color=r,g,b,a>...</color> markup. The visible text of every run is stored
+// null terminated in text so the runs can be drawn without copying
+struct RichTextLayout
+{
+    const char *key = nullptr;
+    std::string source;
+    int fontSize = 0;
+    Color defaultColor{};
+    std::string text;
+    std::vector<RichTextRun> runs;
+    int width = 0;
+    unsigned int lastUsed = 0;
+};
+
+// Layouts are cached by string address, font size and color. The content is compared too,
+// so a different string reusing the same address is laid out again. When the cache is full
+// the least recently used layout is replaced
+class RichText
+{
+private:
+    inline static RichTextLayout layouts[RICH_TEXT_CACHE_SIZE];
+    inline static unsigned int useCounter = 0;
+
+    static void Build(RichTextLayout &layout, const char *text, int fontSize, Color defaultColor);
+
+public:
+    static const RichTextLayout &GetLayout(const char *text, int fontSize, Color defaultColor);
+    static void Clear();
+};
+
+void DrawRichText(const char *text, int posX, int posY, int fontSize, Color defaultColor);
+void DrawRichTextCentered(const char *text, int centerX, int posY, int fontSize, Color defaultColor);
+int MeasureRichText(const char *text, int fontSize);
+
+#endif // RICHTEXT_H
@@ -1,24 +1,69 @@
 #include "SceneManager.h"
+#include "Profiler.h"
 #include <iostream>
+#include <chrono>
 
 void SceneManager::AddScene(const std::string& name, std::shared_ptr<GameScene> scene) {
     scenes[name] = scene;
 }
 
+void SceneManager::SetLoadingScene(std::shared_ptr<GameScene> scene) {
+    if (loadingScene) {
+        loadingScene->Unload();
+    }
+    loadingScene = scene;
+    if (loadingScene) {
+        loadingScene->Load();
+    }
+}
+
 void SceneManager::ChangeScene(const std::string& name) {
+    PROFILE_SCOPE("SceneManager::ChangeScene");
     auto it = scenes.find(name);
-    if (it != scenes.end()) {
-        if (currentScene != nullptr) {
-            currentScene->Unload();
-        }
-        currentScene = it->second;
-        currentScene->Load();
-    } else {
+    if (it == scenes.end()) {
         std::cerr << "Scene '" << name << "' not found." << std::endl;
+        return;
+    }
+
+    // Already on its way
+    if (pendingScene == it->second) {
+        return;
+    }
+
+    // Only one load at a time, finish the previous one before starting the next
+    if (pendingScene) {
+        FinishPendingLoad();
     }
+
+    // Reloading the current scene can't overlap with itself, do it in place
+    if (currentScene == it->second) {
+        currentScene->Unload();
+        currentScene->Load();
+        return;
+    }
+
+    pendingScene = it->second;
+    if (loadingScene) {
+        loadingScene->Load();
+    }
+
+#if defined(PLATFORM_WEB)
+    // No threads on web, the CPU part is done now and the GPU part is still spread over frames
+    pendingScene->LoadAsync();
+#else
+    auto scene = pendingScene;
+    pendingLoad = std::async(std::launch::async, [scene]() {
+        PROFILE_THREAD("Loader");
+        PROFILE_SCOPE("LoadAsync");
+        scene->LoadAsync();
+    });
+#endif
 }
 
 void SceneManager::RemoveScene(const std::string& name) {
+    if (pendingScene && pendingScene->name == name) {
+        FinishPendingLoad();
+    }
     if (currentScene && currentScene->name == name) {
         currentScene->Unload();
         currentScene = nullptr;
@@ -26,6 +71,35 @@ void SceneManager::RemoveScene(const std::string& name) {
     scenes.erase(name);
 }
 
+bool SceneManager::IsPendingLoadDone() {
+    if (!pendingLoad.valid()) {
+        return true;
+    }
+    if (pendingLoad.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return false;
+    }
+    // Rethrows anything the worker threw
+    pendingLoad.get();
+    return true;
+}
+
+void SceneManager::ActivatePendingScene() {
+    if (currentScene != nullptr) {
+        currentScene->Unload();
+    }
+    currentScene = pendingScene;
+    pendingScene = nullptr;
+}
+
+void SceneManager::FinishPendingLoad() {
+    if (pendingLoad.valid()) {
+        pendingLoad.get();
+    }
+    while (!pendingScene->FinalizeLoad(SCENE_FINALIZE_BUDGET)) {
+    }
+    ActivatePendingScene();
+}
+
 void SceneManager::LoadCurrentScene() {
     if (currentScene) {
         currentScene->Load();
@@ -33,19 +107,43 @@ void SceneManager::LoadCurrentScene() {
 }
 
 void SceneManager::UpdateCurrentScene(float deltaTime) {
+    if (pendingScene) {
+        if (loadingScene) {
+            loadingScene->Update(deltaTime);
+        }
+        PROFILE_SCOPE("FinalizeLoad");
+        if (IsPendingLoadDone() && pendingScene->FinalizeLoad(SCENE_FINALIZE_BUDGET)) {
+            ActivatePendingScene();
+        }
+        return;
+    }
+
     if (currentScene) {
+        PROFILE_SCOPE("Scene::Update");
         currentScene->Update(deltaTime);
     }
 }
 
 void SceneManager::RenderCurrentScene() {
+    if (pendingScene && loadingScene) {
+        loadingScene->Render();
+        return;
+    }
+
     if (currentScene) {
+        PROFILE_SCOPE("Scene::Render");
         currentScene->Render();
     }
 }
 
 void SceneManager::UnloadCurrentScene() {
+    if (pendingScene) {
+        FinishPendingLoad();
+    }
     if (currentScene) {
         currentScene->Unload();
     }
+    if (loadingScene) {
+        loadingScene->Unload();
+    }
 }
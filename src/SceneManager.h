@@ -4,15 +4,28 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <future>
 #include "GameScene.h"
 
+// Time spent per frame finishing the main thread part of a scene load
+constexpr double SCENE_FINALIZE_BUDGET = 0.008;
+
 class SceneManager {
 private:
     std::map<std::string, std::shared_ptr<GameScene>> scenes;
     std::shared_ptr<GameScene> currentScene;
 
+    // Scene being loaded, the current scene stays loaded until this one is ready
+    std::shared_ptr<GameScene> pendingScene;
+    std::future<void> pendingLoad;
+    std::shared_ptr<GameScene> loadingScene;
+
     SceneManager() {}
 
+    bool IsPendingLoadDone();
+    void ActivatePendingScene();
+    void FinishPendingLoad();
+
 public:
     SceneManager(const SceneManager&) = delete;
     SceneManager& operator=(const SceneManager&) = delete;
@@ -23,8 +36,10 @@ public:
     }
 
     void AddScene(const std::string& name, std::shared_ptr<GameScene> scene);
+    void SetLoadingScene(std::shared_ptr<GameScene> scene);
     void ChangeScene(const std::string& name);
     void RemoveScene(const std::string& name);
+    bool IsLoading() const { return pendingScene != nullptr; }
 
     void LoadCurrentScene();
     void UpdateCurrentScene(float deltaTime);
@@ -2,51 +2,142 @@
 #define SCHEDULER_H
 
 #include <vector>
-#include <functional>
+#include <algorithm>
+#include <cstdint>
+#include "InplaceFunction.h"
+#include "Profiler.h"
+#include "Counters.h"
+
+using TaskFunction = InplaceFunction<void(), 48>;
+
+inline constexpr uint32_t INVALID_TASK_INDEX = 0xFFFFFFFF;
+
+// Identifies a scheduled task, it stops being valid once the task runs or is cancelled
+struct TaskHandle {
+    uint32_t index = INVALID_TASK_INDEX;
+    uint32_t generation = 0;
+};
 
 struct ScheduledTask {
-    std::function<void()> function;
-    float delay;
-    bool toBeExecuted;
+    TaskFunction function;
+    uint32_t generation = 0;
+    bool active = false;
+};
+
+// Entry of the min-heap of timers, ordered by absolute time and then by scheduling order
+struct TaskTimer {
+    double time;
+    uint64_t sequence;
+    uint32_t index;
+    uint32_t generation;
 };
 
 class Scheduler {
+private:
+    // Pool of task slots, the heap only stores indices into it
+    inline static std::vector<ScheduledTask> tasks;
+    inline static std::vector<uint32_t> freeTasks;
+    inline static std::vector<TaskTimer> timers;
+    inline static double currentTime = 0.0;
+    inline static uint64_t nextSequence = 0;
+
+    inline static bool TimerAfter(const TaskTimer &a, const TaskTimer &b) {
+        return a.time > b.time || (a.time == b.time && a.sequence > b.sequence);
+    }
+
+    inline static void ReleaseTask(uint32_t index) {
+        auto &task = tasks[index];
+        task.function.Reset();
+        task.active = false;
+        task.generation++;
+        freeTasks.push_back(index);
+    }
+
 public:
 
-    // Static list of tasks
-    inline static std::vector<ScheduledTask> tasks;
+    // Preallocates room for a number of simultaneous tasks
+    inline static void Reserve(size_t count) {
+        tasks.reserve(count);
+        freeTasks.reserve(count);
+        timers.reserve(count);
+    }
 
-    // Schedule a function to be called after a delay in seconds
-    inline static void SetTimeout(std::function<void()> function, float delaySeconds) {
-        tasks.push_back({function, delaySeconds, false});
+    // Schedule a function to be called after a delay in seconds. It is safe to call it
+    // from inside a task, tasks scheduled while updating run in the next update at the earliest.
+    inline static TaskHandle SetTimeout(TaskFunction function, float delaySeconds) {
+        uint32_t index;
+        if (!freeTasks.empty()) {
+            index = freeTasks.back();
+            freeTasks.pop_back();
+        } else {
+            index = static_cast<uint32_t>(tasks.size());
+            tasks.emplace_back();
+        }
+
+        auto &task = tasks[index];
+        task.function = std::move(function);
+        task.active = true;
+
+        timers.push_back({currentTime + std::max(0.0f, delaySeconds), nextSequence++, index, task.generation});
+        std::push_heap(timers.begin(), timers.end(), TimerAfter);
+
+        return TaskHandle{index, task.generation};
+    }
+
+    inline static bool IsPending(TaskHandle handle) {
+        return handle.index < tasks.size() &&
+               tasks[handle.index].active &&
+               tasks[handle.index].generation == handle.generation;
+    }
+
+    // Cancels a task that didn't run yet, its timer is discarded when it reaches the top of the heap
+    inline static bool Cancel(TaskHandle handle) {
+        if (!IsPending(handle)) {
+            return false;
+        }
+        ReleaseTask(handle.index);
+        return true;
     }
 
-    // Update the scheduler: decrement delays and execute tasks as needed
+    // Update the scheduler: advance the clock and run the tasks that are due
     inline static void Update(float deltaTime) {
-        for (auto& task : tasks) {
-            if (!task.toBeExecuted) {
-                task.delay -= deltaTime;
-                if (task.delay <= 0) {
-                    task.toBeExecuted = true; // Mark for execution
-                }
+        PROFILE_SCOPE("Scheduler::Update");
+        currentTime += deltaTime;
+        uint64_t sequenceLimit = nextSequence;
+
+        while (!timers.empty()) {
+            const TaskTimer &timer = timers.front();
+            if (timer.time > currentTime || timer.sequence >= sequenceLimit) {
+                break;
             }
-        }
 
-        // Execute and remove all tasks marked for execution
-        auto it = tasks.begin();
-        while (it != tasks.end()) {
-            if (it->toBeExecuted) {
-                it->function();  // Execute the function
-                it = tasks.erase(it);  // Remove the completed task
-            } else {
-                ++it;
+            uint32_t index = timer.index;
+            uint32_t generation = timer.generation;
+            std::pop_heap(timers.begin(), timers.end(), TimerAfter);
+            timers.pop_back();
+
+            auto &task = tasks[index];
+            if (!task.active || task.generation != generation) {
+                continue; // Cancelled
             }
+
+            // The slot is released before running so the task can schedule new tasks freely
+            TaskFunction function = std::move(task.function);
+            ReleaseTask(index);
+            PROFILE_SCOPE("Scheduler::Task");
+            COUNTER_ADD(Counter::SchedulerTasks, 1);
+            function();
         }
     }
 
     // Clear all scheduled tasks
     inline static void Clear() {
-        tasks.clear();
+        for (uint32_t i = 0; i < tasks.size(); i++) {
+            if (tasks[i].active) {
+                ReleaseTask(i);
+            }
+        }
+        timers.clear();
     }
 };
 
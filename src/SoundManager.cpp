@@ -1,36 +1,192 @@
 #include "SoundManager.h"
+#include "Profiler.h"
+#include "Counters.h"
 #include <iostream>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include "raymath.h"
 
-void SoundManager::Init()
+// Distance (in pixels) where a queued sound plays at half volume
+inline constexpr float HALF_VOLUME_DISTANCE = 256.0f;
+// Minimum time between two plays of the same sound
+inline constexpr double SOUND_THROTTLE_TIME = 0.05;
+
+static double AudioTime()
 {
-    // Load all sounds
-    sounds[SFX_DRY] = LoadSound("resources/dry.wav");
-    sounds[SFX_FREEZE] = LoadSound("resources/freeze.wav");
-    sounds[SFX_GRAB] = LoadSound("resources/grab.wav");
-    sounds[SFX_GRASS] = LoadSound("resources/grass.wav");
-    sounds[SFX_HIT] = LoadSound("resources/hit.wav");
-    sounds[SFX_RELEASE] = LoadSound("resources/release.wav");
-    sounds[SFX_HEAL] = LoadSound("resources/heal.wav");
-    sounds[SFX_VICTORY] = LoadSound("resources/victory.wav");
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
 
-    gameMusic = LoadMusicStream("resources/in_game_music.mp3");
-    titleMusic = LoadMusicStream("resources/bg_music.mp3");
+static void AtomicMin(std::atomic<float> &target, float value)
+{
+    float current = target.load(std::memory_order_relaxed);
+    while (value < current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
 }
 
-void SoundManager::Update(float deltaTime)
+static void AtomicMax(std::atomic<float> &target, float value)
+{
+    float current = target.load(std::memory_order_relaxed);
+    while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+// Prefers the cooked PCM of a sound, which needs no decoding, and falls back to the source file
+static Sound LoadSoundPreferCooked(const char *path)
+{
+    PROFILE_SCOPE("LoadSound");
+    CookedAudio cooked;
+    if (LoadCookedAudio(GetCookedAudioPath(path).c_str(), cooked, false))
+    {
+        Sound sound = LoadSoundFromWave(cooked.wave);
+        UnloadCookedAudio(cooked);
+        return sound;
+    }
+    return LoadSound(path);
+}
+
+static void LoadTrack(MusicTrack &track, const char *path)
+{
+    PROFILE_SCOPE("LoadMusic");
+    track.isCooked = LoadCookedStream(GetCookedAudioPath(path).c_str(), track.cooked);
+    if (!track.isCooked)
+    {
+        track.music = LoadMusicStream(path);
+    }
+}
+
+static void UnloadTrack(MusicTrack &track)
+{
+    if (track.isCooked)
+    {
+        UnloadCookedStream(track.cooked);
+    }
+    else
+    {
+        UnloadMusicStream(track.music);
+    }
+    track = MusicTrack{};
+}
+
+static void PlayTrack(MusicTrack &track, float volume)
+{
+    if (track.isCooked)
+    {
+        PlayCookedStream(track.cooked);
+        SetAudioStreamVolume(track.cooked.stream, volume);
+    }
+    else
+    {
+        PlayMusicStream(track.music);
+        SetMusicVolume(track.music, volume);
+    }
+}
+
+static void StopTrack(MusicTrack &track)
 {
+    if (track.isCooked)
+    {
+        StopCookedStream(track.cooked);
+    }
+    else
+    {
+        StopMusicStream(track.music);
+    }
+}
 
-    for (auto &soundTimer : soundTimers)
+static void UpdateTrack(MusicTrack &track)
+{
+    if (track.isCooked)
+    {
+        UpdateCookedStream(track.cooked);
+    }
+    else
+    {
+        UpdateMusicStream(track.music);
+    }
+}
+
+void SoundManager::Init()
+{
+    // Load all sounds and the aliases used as extra voices
+    for (int i = 0; i < static_cast<int>(SoundId::Count); i++)
     {
-        if (soundTimer.second > 0)
+        const auto &definition = SOUND_DEFINITIONS[i];
+        auto &slot = sounds[i];
+
+        slot.voices[0].sound = LoadSoundPreferCooked(definition.path);
+        slot.numVoices = 1;
+        for (int v = 1; v < definition.voices && v < MAX_VOICES_PER_SOUND; v++)
         {
-            soundTimer.second -= deltaTime;
+            slot.voices[v].sound = LoadSoundAlias(slot.voices[0].sound);
+            slot.numVoices++;
         }
+        slot.lastPlayTime = -1.0;
+    }
+
+    LoadTrack(gameMusic, GAME_MUSIC_PATH);
+    LoadTrack(titleMusic, TITLE_MUSIC_PATH);
+    masterVolume = ::GetMasterVolume();
+
+#if !defined(PLATFORM_WEB)
+    running = true;
+    audioThread = std::thread(AudioThreadMain);
+#endif
+}
+
+void SoundManager::Update(float deltaTime)
+{
+    PROFILE_SCOPE("SoundManager::Update");
+#if defined(PLATFORM_WEB)
+    ProcessAudio();
+#endif
+}
+
+void SoundManager::AudioThreadMain()
+{
+    PROFILE_THREAD("Audio");
+    while (running.load(std::memory_order_acquire))
+    {
+        ProcessAudio();
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    // Run what was left so a StopMusic pushed right before Cleanup is not lost
+    ProcessAudio();
+}
+
+void SoundManager::ProcessAudio()
+{
+    PROFILE_SCOPE("SoundManager::ProcessAudio");
+    AudioCommand command;
+    while (commands.Pop(command))
+    {
+        Execute(command);
     }
 
-    if(currentMusicStream != nullptr)
+    if (currentMusicStream != nullptr)
     {
-        UpdateMusicStream(*currentMusicStream);
+        UpdateTrack(*currentMusicStream);
+    }
+}
+
+void SoundManager::Submit(const AudioCommand &command, bool mustArrive)
+{
+    // Sound effects can be dropped if the audio thread falls behind, music changes can't
+    while (!commands.Push(command))
+    {
+        if (!mustArrive)
+        {
+            return;
+        }
+#if defined(PLATFORM_WEB)
+        ProcessAudio();
+#else
+        std::this_thread::yield();
+#endif
     }
 }
 
@@ -38,51 +194,199 @@ void SoundManager::Cleanup()
 {
     StopMusic();
 
-    for (auto &sound : sounds)
+#if !defined(PLATFORM_WEB)
+    running.store(false, std::memory_order_release);
+    if (audioThread.joinable())
     {
-        UnloadSound(sound.second);
+        audioThread.join();
     }
-    sounds.clear();
+#else
+    ProcessAudio();
+#endif
 
-    UnloadMusicStream(gameMusic);
-    UnloadMusicStream(titleMusic);
+    for (auto &slot : sounds)
+    {
+        for (int v = slot.numVoices - 1; v > 0; v--)
+        {
+            UnloadSoundAlias(slot.voices[v].sound);
+        }
+        if (slot.numVoices > 0)
+        {
+            UnloadSound(slot.voices[0].sound);
+        }
+        slot.numVoices = 0;
+    }
+
+    UnloadTrack(gameMusic);
+    UnloadTrack(titleMusic);
 }
 
+// Returns a free voice, or steals the oldest voice with the lowest priority
+// if it is not more important than the new sound
+static SoundVoice *AcquireVoice(SoundSlot &slot, int priority)
+{
+    SoundVoice *candidate = nullptr;
+    for (int v = 0; v < slot.numVoices; v++)
+    {
+        auto &voice = slot.voices[v];
+        if (!IsSoundPlaying(voice.sound))
+        {
+            return &voice;
+        }
+
+        if (!candidate ||
+            voice.priority < candidate->priority ||
+            (voice.priority == candidate->priority && voice.startTime < candidate->startTime))
+        {
+            candidate = &voice;
+        }
+    }
+
+    if (candidate && candidate->priority <= priority)
+    {
+        StopSound(candidate->sound);
+        return candidate;
+    }
+    return nullptr;
+}
 
-void SoundManager::PlaySound(const std::string &soundFile, float volume, float pitchVariance)
+void SoundManager::Execute(const AudioCommand &command)
 {
-    if (soundTimers[soundFile] > 0)
+    switch (command.type)
     {
-        return;
+    case AudioCommandType::PlaySound:
+    {
+        auto &slot = sounds[static_cast<int>(command.sound)];
+        double now = AudioTime();
+        if (slot.lastPlayTime >= 0.0 && now - slot.lastPlayTime < SOUND_THROTTLE_TIME)
+        {
+            return;
+        }
+
+        auto voice = AcquireVoice(slot, command.priority);
+        if (!voice)
+        {
+            return;
+        }
+        slot.lastPlayTime = now;
+
+        SetSoundPitch(voice->sound, command.pitch);
+        SetSoundVolume(voice->sound, command.volume);
+        voice->priority = command.priority;
+        voice->startTime = now;
+        ::PlaySound(voice->sound);
+        COUNTER_ADD(Counter::SoundsPlayed, 1);
+        break;
     }
-    soundTimers[soundFile] = 0.05;
+    case AudioCommandType::PlayMusic:
+        if (currentMusicStream != nullptr)
+        {
+            StopTrack(*currentMusicStream); // Stop current music if it is playing
+        }
+        currentMusicStream = command.music; // Set the new music stream
+        PlayTrack(*currentMusicStream, command.volume);
+        break;
+    case AudioCommandType::StopMusic:
+        if (currentMusicStream != nullptr)
+        {
+            StopTrack(*currentMusicStream);
+            currentMusicStream = nullptr;
+        }
+        break;
+    case AudioCommandType::SetMasterVolume:
+        ::SetMasterVolume(command.volume);
+        break;
+    default:
+        break;
+    }
+}
 
-    if (sounds.find(soundFile) == sounds.end())
+void SoundManager::PlaySound(SoundId sound, float volume, float pitchVariance, int priority)
+{
+    if (priority < 0)
     {
-        sounds[soundFile] = LoadSound(soundFile.c_str());
+        priority = SOUND_DEFINITIONS[static_cast<int>(sound)].priority;
     }
-    float pitch = 1.0f + (GetRandomValue(-100, 100) / 1000.0f) * pitchVariance;
-    SetSoundPitch(sounds[soundFile], pitch);
-    SetSoundVolume(sounds[soundFile], volume);
-    ::PlaySound(sounds[soundFile]);
+
+    COUNTER_ADD(Counter::SoundRequests, 1);
+
+    AudioCommand command;
+    command.type = AudioCommandType::PlaySound;
+    command.sound = sound;
+    command.volume = volume;
+    command.pitch = 1.0f + (GetRandomValue(-100, 100) / 1000.0f) * pitchVariance;
+    command.priority = priority;
+    Submit(command, false);
+}
+
+void SoundManager::SetListener(Vector2 position)
+{
+    listenerX.store(position.x, std::memory_order_relaxed);
+    listenerY.store(position.y, std::memory_order_relaxed);
 }
 
-void SoundManager::PlayMusic(Music &music, float volume)
+void SoundManager::QueueSound(SoundId sound, float volume, float pitchVariance, Vector2 position)
 {
-    if (currentMusicStream != nullptr) {
-        StopMusicStream(*currentMusicStream); // Stop current music if it is playing
+    auto &pending = pendingSounds[static_cast<int>(sound)];
+    Vector2 listener = {listenerX.load(std::memory_order_relaxed), listenerY.load(std::memory_order_relaxed)};
+    float distance = Vector2Distance(listener, position);
+    pending.count.fetch_add(1, std::memory_order_relaxed);
+    AtomicMin(pending.nearestDistance, distance);
+    AtomicMax(pending.volume, volume);
+    pending.pitchVariance.store(pitchVariance, std::memory_order_relaxed);
+}
+
+void SoundManager::Flush()
+{
+    PROFILE_SCOPE("SoundManager::Flush");
+    for (int i = 0; i < static_cast<int>(SoundId::Count); i++)
+    {
+        auto &pending = pendingSounds[i];
+        int count = pending.count.exchange(0, std::memory_order_relaxed);
+        if (count == 0)
+        {
+            continue;
+        }
+
+        // Quieter with the distance to the nearest event, louder when many events happened at once
+        float distance = pending.nearestDistance.exchange(std::numeric_limits<float>::max(), std::memory_order_relaxed);
+        float attenuation = 1.0f / (1.0f + distance / HALF_VOLUME_DISTANCE);
+        float boost = 1.0f + 0.25f * log2f(static_cast<float>(count));
+        float volume = std::min(1.0f, pending.volume.exchange(0.0f, std::memory_order_relaxed) * attenuation * boost);
+
+        // PlaySound counts one request, the rest were coalesced into it
+        COUNTER_ADD(Counter::SoundRequests, count - 1);
+        PlaySound(static_cast<SoundId>(i), volume, pending.pitchVariance.load(std::memory_order_relaxed));
     }
-    
-    currentMusicStream = &music; // Set the new music stream
-    PlayMusicStream(music); // Play the new music
-    // Set the volume of the music
-    SetMusicVolume(music, volume);
+}
+
+void SoundManager::PlayMusic(MusicTrack &music, float volume)
+{
+    AudioCommand command;
+    command.type = AudioCommandType::PlayMusic;
+    command.music = &music;
+    command.volume = volume;
+    Submit(command, true);
 }
 
 void SoundManager::StopMusic()
 {
-    if (currentMusicStream != nullptr) {
-        StopMusicStream(*currentMusicStream); // Stop the music
-        currentMusicStream = nullptr;
-    }
-}
\ No newline at end of file
+    AudioCommand command;
+    command.type = AudioCommandType::StopMusic;
+    Submit(command, true);
+}
+
+void SoundManager::SetMasterVolume(float volume)
+{
+    masterVolume = Clamp(volume, 0.0f, 1.0f);
+
+    AudioCommand command;
+    command.type = AudioCommandType::SetMasterVolume;
+    command.volume = masterVolume;
+    Submit(command, true);
+}
+
+float SoundManager::GetMasterVolume()
+{
+    return masterVolume;
+}
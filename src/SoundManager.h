@@ -3,35 +3,157 @@
 #define SOUND_MANAGER_H
 
 #include "raylib.h"
-#include <vector>
-#include <unordered_map>
-#include <string>
-
-inline const std::string SFX_DRY = "dry";
-inline const std::string SFX_FREEZE = "freeze";
-inline const std::string SFX_GRAB = "grab";
-inline const std::string SFX_GRASS = "grass";
-inline const std::string SFX_HIT = "hit";
-inline const std::string SFX_RELEASE = "release";
-inline const std::string SFX_HEAL = "heal";
-inline const std::string SFX_VICTORY = "victory";
+#include <atomic>
+#include <thread>
+#include <limits>
+#include "SpscQueue.h"
+#include "CookedAudio.h"
 
+enum class SoundId
+{
+    Dry = 0,
+    Freeze,
+    Grab,
+    Grass,
+    Hit,
+    Release,
+    Heal,
+    Victory,
+    Count
+};
+
+inline constexpr SoundId SFX_DRY = SoundId::Dry;
+inline constexpr SoundId SFX_FREEZE = SoundId::Freeze;
+inline constexpr SoundId SFX_GRAB = SoundId::Grab;
+inline constexpr SoundId SFX_GRASS = SoundId::Grass;
+inline constexpr SoundId SFX_HIT = SoundId::Hit;
+inline constexpr SoundId SFX_RELEASE = SoundId::Release;
+inline constexpr SoundId SFX_HEAL = SoundId::Heal;
+inline constexpr SoundId SFX_VICTORY = SoundId::Victory;
+
+inline constexpr int MAX_VOICES_PER_SOUND = 4;
+inline constexpr size_t AUDIO_COMMAND_QUEUE_SIZE = 256;
+
+struct SoundDefinition
+{
+    const char *path;
+    int voices;
+    int priority;
+};
+
+inline constexpr auto GAME_MUSIC_PATH = "resources/in_game_music.mp3";
+inline constexpr auto TITLE_MUSIC_PATH = "resources/bg_music.mp3";
+
+// Indexed by SoundId
+inline constexpr SoundDefinition SOUND_DEFINITIONS[] = {
+    {"resources/dry.wav", 4, 0},
+    {"resources/freeze.wav", 4, 0},
+    {"resources/grab.wav", 2, 1},
+    {"resources/grass.wav", 4, 0},
+    {"resources/hit.wav", 2, 2},
+    {"resources/release.wav", 2, 1},
+    {"resources/heal.wav", 2, 1},
+    {"resources/victory.wav", 1, 3},
+};
+static_assert(sizeof(SOUND_DEFINITIONS) / sizeof(SOUND_DEFINITIONS[0]) == static_cast<int>(SoundId::Count));
+
+// Requests of the same sound queued during a frame, only the nearest one is played.
+// Atomic so the simulation can queue sounds from any thread.
+struct PendingSound
+{
+    std::atomic<int> count{0};
+    std::atomic<float> nearestDistance{std::numeric_limits<float>::max()};
+    std::atomic<float> volume{0.0f};
+    std::atomic<float> pitchVariance{0.0f};
+};
+
+struct SoundVoice
+{
+    Sound sound{};
+    int priority = 0;
+    double startTime = 0.0;
+};
+
+// The first voice owns the sample data, the rest are aliases that share it
+struct SoundSlot
+{
+    SoundVoice voices[MAX_VOICES_PER_SOUND];
+    int numVoices = 0;
+    double lastPlayTime = -1.0;
+};
+
+// A music track plays from its cooked PCM when available, otherwise it is decoded from the source file
+struct MusicTrack
+{
+    Music music{};
+    CookedStream cooked{};
+    bool isCooked = false;
+};
+
+enum class AudioCommandType
+{
+    PlaySound = 0,
+    PlayMusic,
+    StopMusic,
+    SetMasterVolume,
+    Count
+};
+
+struct AudioCommand
+{
+    AudioCommandType type = AudioCommandType::PlaySound;
+    SoundId sound = SoundId::Count;
+    float volume = 0.0f;
+    float pitch = 1.0f;
+    int priority = 0;
+    MusicTrack *music = nullptr;
+};
+
+// Every raylib audio call happens on the audio thread (or in Update on the web build,
+// which has no threads). The rest of the game talks to it through a command queue
+// filled from the main thread.
 class SoundManager
 {
 public:
-    inline static Music titleMusic;
-    inline static Music gameMusic;
+    inline static MusicTrack titleMusic;
+    inline static MusicTrack gameMusic;
 private:
-    inline static std::unordered_map<std::string, Sound> sounds;
-    inline static std::unordered_map<std::string, float> soundTimers;
-    inline static Music *currentMusicStream = nullptr;
+    inline static SoundSlot sounds[static_cast<int>(SoundId::Count)];
+    inline static PendingSound pendingSounds[static_cast<int>(SoundId::Count)];
+    // Written by the main thread, read by the threads queueing sounds
+    inline static std::atomic<float> listenerX{0.0f};
+    inline static std::atomic<float> listenerY{0.0f};
+    inline static float masterVolume = 1.0f;
+
+    inline static SpscQueue<AudioCommand, AUDIO_COMMAND_QUEUE_SIZE> commands;
+    inline static std::thread audioThread;
+    inline static std::atomic<bool> running{false};
+
+    // Only touched by the audio thread
+    inline static MusicTrack *currentMusicStream = nullptr;
+
+    static void Submit(const AudioCommand &command, bool mustArrive);
+    static void Execute(const AudioCommand &command);
+    static void AudioThreadMain();
 public:
     static void Init();
     static void Update(float deltaTime);
-    static void PlaySound(const std::string &soundFile, float volume, float pitchVariance);
+    // A negative priority uses the default priority of the sound. Main thread only, other
+    // threads use QueueSound
+    static void PlaySound(SoundId sound, float volume, float pitchVariance, int priority = -1);
+    // Positional sounds are queued and coalesced per sound, Flush plays them once per frame.
+    // QueueSound can be called from any thread, SetListener and Flush only from the main thread
+    static void SetListener(Vector2 position);
+    static void QueueSound(SoundId sound, float volume, float pitchVariance, Vector2 position);
+    static void Flush();
     static void Cleanup();
-    static void PlayMusic(Music &music, float volume);
+    static void PlayMusic(MusicTrack &music, float volume);
     static void StopMusic();
+    static void SetMasterVolume(float volume);
+    static float GetMasterVolume();
+    // Runs the queued commands on the calling thread. The audio thread calls it on native
+    // builds, Update on the web build, tools without an audio thread call it directly
+    static void ProcessAudio();
 };
 
-#endif // SOUND_MANAGER_H
\ No newline at end of file
+#endif // SOUND_MANAGER_H
@@ -3,29 +3,39 @@
 #include "utils.h"
 #include "constants.h"
 #include "SceneManager.h"
-#include "Scheduler.h"
 #include "SoundManager.h"
 
 
 SplashScene::SplashScene() : GameScene("Splash Scene") {}
 
 void SplashScene::Load() {
+    LoadAsync();
+    FinalizeLoad(0.0);
+}
+
+void SplashScene::LoadAsync() {
     std::cout << "Loading Splash Scene resources..." << std::endl;
-    background =  LoadTexture("resources/splash.png");
+    backgroundImage = LoadImage("resources/splash.png");
+    distortionShaderCode = LoadFileText(distortion_shader_path);
 
-    titleSize = MeasureText("Spring MUST Come", 40);
-    pressEnterToStartSize = MeasureText("Press [SPACE] to start", 20);
+    timeElapsed = 0.0f;
+    fadeOutOpacity = 0.0f;
+    changeSceneSheduled = false;
+    fadeTime = 0.5f;
+}
 
+bool SplashScene::FinalizeLoad(double timeBudget) {
+    // Small enough to be uploaded in a single frame
+    background = LoadTextureFromImage(backgroundImage);
+    UnloadImage(backgroundImage);
 
-    distortionShader = LoadDistorionShader();
+    distortionShader = LoadShaderFromCode(distortionShaderCode);
+    distortionShaderCode = nullptr;
     float resolution[2] = {(float)GetScreenWidth(), (float)GetScreenHeight()};
     SetShaderValue(distortionShader, GetShaderLocation(distortionShader, "resolution"), resolution, SHADER_UNIFORM_VEC2);
 
-    timeElapsed = 0.0f;
-    fadeOutOpacity = 0.0f;
-    changeSceneSheduled = false;
-    fadeTime = 0.5f;
     SoundManager::PlayMusic(SoundManager::titleMusic, 0.6f);
+    return true;
 }
 
 void SplashScene::Update(float deltaTime)
@@ -38,16 +48,20 @@ void SplashScene::Update(float deltaTime)
         if(!changeSceneSheduled)
         {
             changeSceneSheduled = true;
-            Scheduler::SetTimeout([](){
-                SceneManager::GetInstance().ChangeScene("InGame");
-            }, fadeTime);
+            fadeScript = Scripts::Start(FadeOutToGame());
         }
     }
+}
 
-    if (changeSceneSheduled) {
-        fadeOutOpacity += deltaTime * 1 / fadeTime;
-        if (fadeOutOpacity > 1.0f) fadeOutOpacity = 1.0f;
+Script SplashScene::FadeOutToGame()
+{
+    while (fadeOutOpacity < 1.0f)
+    {
+        co_await NextFrame();
+        fadeOutOpacity += GetFrameTime() / fadeTime;
     }
+    fadeOutOpacity = 1.0f;
+    SceneManager::GetInstance().ChangeScene("InGame");
 }
 
 void SplashScene::Render()
@@ -58,8 +72,8 @@ void SplashScene::Render()
 
     DrawRectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, Fade(BLACK, 0.7f));
 
-    DrawRichText("Spring <color=0,255,155,255>MUST</color> Come", SCREEN_WIDTH / 2 - titleSize / 2, 100, 40, WHITE);
-    DrawRichText("Press <color=0,255,155,255> [SPACE] </color> to start", SCREEN_WIDTH / 2 - pressEnterToStartSize /2, SCREEN_HEIGHT / 2 + 100, 20, WHITE);
+    DrawRichTextCentered("Spring <color=0,255,155,255>MUST</color> Come", SCREEN_WIDTH / 2, 100, 40, WHITE);
+    DrawRichTextCentered("Press <color=0,255,155,255> [SPACE] </color> to start", SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2 + 100, 20, WHITE);
 
     DrawRichText("Made with <color=255,0,0,255>Love</color> in 48h by <color=0,255,155,255>Cristian Muriel</color> for Ludum Dare 55", 10, SCREEN_HEIGHT - 30, 20, WHITE);
 
@@ -72,6 +86,7 @@ void SplashScene::Render()
 
 void SplashScene::Unload() {
     std::cout << "Unloading Splash Scene resources..." << std::endl;
+    Scripts::Stop(fadeScript);
     UnloadTexture(background);
     UnloadShader(distortionShader);
 }
@@ -4,6 +4,7 @@
 #include "GameScene.h"
 
 #include "raylib.h"
+#include "Coroutine.h"
 
 class SplashScene : public GameScene {
 public:
@@ -12,16 +13,21 @@ public:
     virtual void Update(float deltaTime) override;
     virtual void Render() override;
     virtual void Unload() override;
+    virtual void LoadAsync() override;
+    virtual bool FinalizeLoad(double timeBudget) override;
 private:
+    Script FadeOutToGame();
+
     Texture2D background;
+    Image backgroundImage;
+    char *distortionShaderCode = nullptr;
 
-    int titleSize;
-    int pressEnterToStartSize;
     bool changeSceneSheduled = false;
     float fadeOutOpacity = 0.0f;
     Shader distortionShader;
     float timeElapsed = 0.0f;
     float fadeTime = 0.5f;
+    ScriptHandle fadeScript;
 };
 
 #endif // SPLASHSCENE_H
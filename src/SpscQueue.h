@@ -0,0 +1,46 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+// Lock-free ring for one producer thread and one consumer thread.
+// Capacity must be a power of two, one slot is always left empty.
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    bool Push(const T &item)
+    {
+        size_t tail = tailIndex.load(std::memory_order_relaxed);
+        size_t next = (tail + 1) & (Capacity - 1);
+        if (next == headIndex.load(std::memory_order_acquire))
+        {
+            return false; // Full
+        }
+        items[tail] = item;
+        tailIndex.store(next, std::memory_order_release);
+        return true;
+    }
+
+    bool Pop(T &item)
+    {
+        size_t head = headIndex.load(std::memory_order_relaxed);
+        if (head == tailIndex.load(std::memory_order_acquire))
+        {
+            return false; // Empty
+        }
+        item = items[head];
+        headIndex.store((head + 1) & (Capacity - 1), std::memory_order_release);
+        return true;
+    }
+
+private:
+    T items[Capacity];
+    alignas(64) std::atomic<size_t> headIndex{0};
+    alignas(64) std::atomic<size_t> tailIndex{0};
+};
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,82 @@
+#ifndef TILE_STATE_H
+#define TILE_STATE_H
+
+#include <algorithm>
+#include <cstdint>
+
+// State of a tile between 0 (dry) and 1 (snow). Built with TILE_STATE_BITS=16 or 8 it is stored
+// in fixed point, a half or a quarter of the bytes of the float, for the two passes that go
+// through every tile. A step only moves a state by a fraction of a unit in fixed point, so the
+// lerp rounds up with a probability equal to the fraction: on average it moves like the float.
+// ENABLE_TILE_STATE_VALIDATION keeps the float states next to them to measure the difference.
+#if !defined(TILE_STATE_BITS)
+using TileState = float;
+inline constexpr bool TILE_STATE_QUANTIZED = false;
+#elif TILE_STATE_BITS == 16
+using TileState = uint16_t;
+inline constexpr bool TILE_STATE_QUANTIZED = true;
+#elif TILE_STATE_BITS == 8
+using TileState = uint8_t;
+inline constexpr bool TILE_STATE_QUANTIZED = true;
+#else
+#error "TILE_STATE_BITS must be 16 or 8"
+#endif
+
+#if defined(TILE_STATE_BITS)
+inline constexpr int TILE_STATE_ONE = (1 << TILE_STATE_BITS) - 1;
+// Fraction bits of the lerp amount, and the largest amount (a state next to the target gets
+// amounts in the thousands, the step is the same in both cases)
+inline constexpr int TILE_STATE_LERP_BITS = 16;
+inline constexpr float TILE_STATE_MAX_LERP = 65536.0f;
+#endif
+
+inline TileState ToTileState(float value)
+{
+#if defined(TILE_STATE_BITS)
+    return static_cast<TileState>(std::clamp(value, 0.0f, 1.0f) * TILE_STATE_ONE + 0.5f);
+#else
+    return value;
+#endif
+}
+
+inline float FromTileState(TileState state)
+{
+#if defined(TILE_STATE_BITS)
+    return static_cast<float>(state) * (1.0f / TILE_STATE_ONE);
+#else
+    return state;
+#endif
+}
+
+// Largest state at or below the bound of a band, state <= it is the same test as with floats
+inline TileState GetTileStateBound(float bound)
+{
+#if defined(TILE_STATE_BITS)
+    return static_cast<TileState>(std::clamp(static_cast<double>(bound), 0.0, 1.0) * TILE_STATE_ONE);
+#else
+    return bound;
+#endif
+}
+
+// Lerp(current, target, t), the fixed point one rounded up when the fraction beats the high 16
+// bits of dither
+inline TileState LerpTileState(TileState current, TileState target, float t, uint32_t dither)
+{
+#if defined(TILE_STATE_BITS)
+    auto amount = static_cast<int64_t>(std::min(t, TILE_STATE_MAX_LERP) * (1 << TILE_STATE_LERP_BITS));
+    int64_t moved = ((static_cast<int64_t>(target) - current) * amount + (dither >> 16)) >> TILE_STATE_LERP_BITS;
+    return static_cast<TileState>(std::clamp<int64_t>(current + moved, 0, TILE_STATE_ONE));
+#else
+    return current + t * (target - current);
+#endif
+}
+
+// Dither of the next tile: the golden ratio sequence spreads the values evenly, so a run of
+// tiles rounds up in proportion to the fractions. Start it from a random value every step
+inline uint32_t NextTileDither(uint32_t &dither)
+{
+    dither += 0x9e3779b9u;
+    return dither;
+}
+
+#endif // TILE_STATE_H
@@ -1,19 +1,56 @@
 #include "raylib.h"
+#include <cstring>
+#include <cstdlib>
 #include "SplashScene.h"
 #include "InGameScene.h"
+#include "LoadingScene.h"
 #include "SceneManager.h"
 #include "constants.h"
 #include "Scheduler.h"
+#include "Coroutine.h"
 #include "SoundManager.h"
+#include "Profiler.h"
+#include "Replay.h"
+#include "AllocTracker.h"
+#include "Arena.h"
 
-int main()
+int main(int argc, char **argv)
 {
+    PROFILE_THREAD("Main");
+
+    // --trace N captures the first N frames (only in profiling builds)
+    // --record FILE saves the input of the last attempt played, --replay FILE plays it back
+    // --alloc-budget N warns about frames with more than N allocations (only with ALLOC_TRACKING=1)
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (strcmp(argv[i], "--trace") == 0)
+        {
+            PROFILE_CAPTURE(atoi(argv[i + 1]));
+        }
+        else if (strcmp(argv[i], "--record") == 0)
+        {
+            Replays::RecordTo(argv[i + 1]);
+        }
+        else if (strcmp(argv[i], "--replay") == 0)
+        {
+            Replays::PlayFrom(argv[i + 1]);
+        }
+        else if (strcmp(argv[i], "--alloc-budget") == 0)
+        {
+            ALLOC_FRAME_BUDGET(strtoull(argv[i + 1], nullptr, 10));
+        }
+    }
+
     InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, TITLE);
     InitAudioDevice();
     SoundManager::Init();
+    Scheduler::Reserve(4096);
+    Scripts::Reserve(1024);
+    FrameArena::Init();
 
     // Create the scenes and add them to the scene manager
     SceneManager& sceneManager = SceneManager::GetInstance();
+    sceneManager.SetLoadingScene(std::make_shared<LoadingScene>());
     sceneManager.AddScene("Splash", std::make_shared<SplashScene>());
     sceneManager.AddScene("InGame", std::make_shared<InGameScene>());
     sceneManager.ChangeScene("Splash");
@@ -23,27 +60,43 @@ int main()
 
     while (!WindowShouldClose())
     {
-        float deltaTime = GetFrameTime();
+        // Nothing allocated from the frame arena survives the frame
+        FrameArena::Reset();
+        {
+            PROFILE_SCOPE("Frame");
+            float deltaTime = GetFrameTime();
+
+            SoundManager::Update(deltaTime);
+            Scheduler::Update(deltaTime);
 
-        SoundManager::Update(deltaTime);
-        Scheduler::Update(deltaTime);
-     
-        sceneManager.UpdateCurrentScene(deltaTime);
+            sceneManager.UpdateCurrentScene(deltaTime);
 
-        BeginDrawing();
-        ClearBackground(DARKGRAY);
-        sceneManager.RenderCurrentScene();
-        EndDrawing();
+            BeginDrawing();
+            ClearBackground(DARKGRAY);
+            sceneManager.RenderCurrentScene();
+            PROFILE_OVERLAY();
+            {
+                // Includes waiting for vsync / the target FPS
+                PROFILE_SCOPE("EndDrawing");
+                EndDrawing();
+            }
 
+            SoundManager::Flush();
+        }
+        PROFILE_FRAME();
+        ALLOC_END_FRAME();
     }
 
     // Clear scheduler for security
     Scheduler::Clear();
+    CoroutineFramePool::Clear();
+    FrameArena::Shutdown();
 
     sceneManager.UnloadCurrentScene();
     SoundManager::Cleanup();
     CloseAudioDevice();
     CloseWindow();
+    ALLOC_SUMMARY();
 
     return 0;
 }
@@ -4,6 +4,9 @@
 #include <iostream>
 #include "raylib.h"
 #include "constants.h"
+#include "SoundManager.h"
+#include "RichText.h"
+#include "Profiler.h"
 
 inline std::random_device rd;
 inline std::mt19937 mt(rd());
@@ -24,84 +27,54 @@ inline Vector2 GetRandomVector(float minX, float minY, float maxX, float maxY) {
     return Vector2{distX(mt), distY(mt)};
 }
 
-// Helper function to convert color string "r,g,b,a" to Color structure
-inline Color ParseColor(const std::string& colorString) {
-    int r, g, b, a;
-    sscanf(colorString.c_str(), "%d,%d,%d,%d", &r, &g, &b, &a);
-    return { static_cast<unsigned char>(r),
-             static_cast<unsigned char>(g),
-             static_cast<unsigned char>(b),
-             static_cast<unsigned char>(a) };
+// Same helpers on a given generator, the simulation uses its own so it can be seeded
+// and so independent worlds can run on different threads
+inline float GetRandomFloat(std::mt19937 &random, float min, float max) {
+    std::uniform_real_distribution<float> dist(min, max);
+    return dist(random);
 }
 
-inline std::string FormatText(const char* format, int value) {
-    char buffer[128]; // Ensure buffer is large enough for your formatting needs
-    snprintf(buffer, sizeof(buffer), format, value);
-    return std::string(buffer);
+inline int GetRandomInt(std::mt19937 &random, int min, int max) {
+    std::uniform_int_distribution<int> dist(min, max);
+    return dist(random);
 }
 
-
-inline void DrawRichText(const char* text, int posX, int posY, int fontSize, Color defaultColor) {
-    std::string strText = text;
-    size_t start = 0;
-    size_t end = 0;
-    Color currentColor = defaultColor;
-    int currentX = posX;
-
-    while (start < strText.length()) {
-        end = strText.find("<color=", start);
-        size_t endColorTag = strText.find("</color>", start);
-
-        if (end != std::string::npos && (end < endColorTag || endColorTag == std::string::npos)) {
-            // Draw the text before the <color=...> tag
-            DrawText(strText.substr(start, end - start).c_str(), currentX, posY, fontSize, currentColor);
-            currentX += MeasureText(strText.substr(start, end - start).c_str(), fontSize);
-
-            // Find the closing bracket of the color tag
-            size_t closeBracket = strText.find('>', end);
-            if (closeBracket != std::string::npos) {
-                std::string color = strText.substr(end + 7, closeBracket - (end + 7));
-                currentColor = ParseColor(color);
-                start = closeBracket + 1;
-            } else {
-                // Malformed tag
-                break;
-            }
-        } else if (endColorTag != std::string::npos) {
-            // Draw the text before the </color> tag
-            DrawText(strText.substr(start, endColorTag - start).c_str(), currentX, posY, fontSize, currentColor);
-            currentX += MeasureText(strText.substr(start, endColorTag - start).c_str(), fontSize);
-
-            currentColor = defaultColor;
-            start = endColorTag + 8;
-        } else {
-            // No more tags, draw the rest of the text
-            DrawText(strText.substr(start).c_str(), currentX, posY, fontSize, currentColor);
-            break;
-        }
-    }
+inline Vector2 GetRandomVector(std::mt19937 &random, float minX, float minY, float maxX, float maxY) {
+    std::uniform_real_distribution<float> distX(minX, maxX);
+    std::uniform_real_distribution<float> distY(minY, maxY);
+    return Vector2{distX(random), distY(random)};
 }
 
-inline Shader LoadDistorionShader() {
-    Shader distortionShader;
-    // if platform is web
+// if platform is web
 #if defined(PLATFORM_WEB)
-    distortionShader = LoadShader(NULL, "resources/distortion_web.fs");
+inline const auto distortion_shader_path = "resources/distortion_web.fs";
+inline const auto entities_shader_path = "resources/entities_web.fs";
+inline const auto particles_shader_path = "resources/particles_web.fs";
 #else
-    distortionShader = LoadShader(NULL, "resources/distortion.fs");
+inline const auto distortion_shader_path = "resources/distortion.fs";
+inline const auto entities_shader_path = "resources/entities.fs";
+inline const auto particles_shader_path = "resources/particles.fs";
 #endif
-    return distortionShader;
+
+inline Shader LoadDistorionShader() {
+    return LoadShader(NULL, distortion_shader_path);
 }
 
 inline Shader LoadEntitiesShader() {
-    Shader entitiesShader;
-    // if platform is web
-#if defined(PLATFORM_WEB)
-    entitiesShader = LoadShader(NULL, "resources/entities_web.fs");
-#else
-    entitiesShader = LoadShader(NULL, "resources/entities.fs");
-#endif
-    return entitiesShader;
+    return LoadShader(NULL, entities_shader_path);
+}
+
+inline Shader LoadParticlesShader() {
+    return LoadShader(NULL, particles_shader_path);
+}
+
+// Second half of a shader loaded in two steps: the code is read with LoadFileText on any
+// thread and compiled here on the main thread, the code is released after compiling
+inline Shader LoadShaderFromCode(char *fragmentCode) {
+    PROFILE_SCOPE("LoadShader");
+    Shader shader = LoadShaderFromMemory(NULL, fragmentCode);
+    UnloadFileText(fragmentCode);
+    return shader;
 }
 
 
@@ -115,16 +88,16 @@ inline void EnableVolumeOptions(bool render)
 
     if (IsKeyReleased(KEY_V))
     {
-        SetMasterVolume(GetMasterVolume() > 0.0f ? 0.0f : 1.0f);
+        SoundManager::SetMasterVolume(SoundManager::GetMasterVolume() > 0.0f ? 0.0f : 1.0f);
     }
 
     if (IsKeyReleased(KEY_U))
     {
-        SetMasterVolume(GetMasterVolume() + 0.1f);
+        SoundManager::SetMasterVolume(SoundManager::GetMasterVolume() + 0.1f);
     }
 
     if (IsKeyReleased(KEY_J))
     {
-        SetMasterVolume(GetMasterVolume() - 0.1f);
+        SoundManager::SetMasterVolume(SoundManager::GetMasterVolume() - 0.1f);
     }
 }
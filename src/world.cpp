@@ -6,19 +6,26 @@
 #include <cmath>
 #include "raymath.h"
 #include <algorithm>
+#include <charconv>
 #include "utils.h"
 #include <limits>
 #include "FxManager.h"
-#include "SoundManager.h"
+#include "Profiler.h"
+#include "Counters.h"
 
 inline const auto player_texture_path = "resources/player.png";
 inline const auto ground_texture_path = "resources/ground.png";
 
-std::vector<std::vector<int>> LoadDataMatrix(const std::string &path, int &width, int &height)
+// Textures queued by LoadWorldData
+inline constexpr size_t WORLD_TEXTURE_COUNT = 12;
+// Room in the world arena for the tutorial texts and the pending textures
+inline constexpr size_t WORLD_ARENA_SLACK = 16 * 1024;
+
+LevelMatrix LoadDataMatrix(const std::string &path, int &width, int &height, std::pmr::memory_resource *resource)
 {
     std::ifstream file(path);
-    std::vector<std::vector<int>> matrix;
-    std::string line;
+    LevelMatrix matrix(resource);
+    std::pmr::string line(resource);
     height = 0;
 
     if (!file.is_open())
@@ -30,19 +37,32 @@ std::vector<std::vector<int>> LoadDataMatrix(const std::string &path, int &width
     }
 
     int maxColumns = 0;
-    while (getline(file, line))
+    while (std::getline(file, line))
     {
-        std::vector<int> row;
-        std::istringstream iss(line);
-        std::string token;
+        std::pmr::vector<int> row(resource);
+        row.reserve(maxColumns);
 
-        while (getline(iss, token, ','))
+        // Comma separated integers, a trailing comma ends the row
+        const char *cursor = line.data();
+        const char *end = line.data() + line.size();
+        while (cursor < end && *cursor != '\r')
         {
-            row.push_back(std::stoi(token));
+            while (cursor < end && *cursor == ' ')
+            {
+                cursor++;
+            }
+            int value = 0;
+            auto result = std::from_chars(cursor, end, value);
+            row.push_back(value);
+            cursor = std::find(result.ptr, end, ',');
+            if (cursor < end)
+            {
+                cursor++;
+            }
         }
 
         maxColumns = std::max(maxColumns, static_cast<int>(row.size()));
-        matrix.push_back(row);
+        matrix.push_back(std::move(row));
         height++;
     }
 
@@ -69,12 +89,11 @@ std::vector<std::vector<int>> LoadDataMatrix(const std::string &path, int &width
     return matrix;
 }
 
-Texture2D GetTextureFromPath(const std::string &path)
+// Decodes the image now (any thread) and leaves the GPU upload for UploadWorldTextures
+void QueueTextureFromPath(World *world, Texture2D *texture, const std::string &path)
 {
-    Image image = LoadImage(path.c_str());
-    auto texture = LoadTextureFromImage(image);
-    UnloadImage(image);
-    return texture;
+    PROFILE_SCOPE("LoadImage");
+    world->pendingTextures.push_back({texture, LoadImage(path.c_str())});
 }
 
 std::vector<TutorialText> LoadTutorialText(const std::string &path)
@@ -142,44 +161,85 @@ std::vector<TutorialText> LoadTutorialText(const std::string &path)
     return tutorials;
 }
 
-World *LoadWorld(int level,
-                 const std::string &worldPath,
-                 const std::string &entitiesPath,
-                 const std::string &tutorialPath)
+void AttachEmitters(World *world, Elemental &elemental)
 {
-    FXManager::Init();
-    auto world = new World();
-    world->currentLevel = level;
-    int width = 0;
-    int height = 0;
+    switch (elemental.type)
+    {
+    case ElementalType::Fire:
+        elemental.emitter = MakeElementalAuraEmitter(RED, world->elementalRange, TILE_SIZE);
+        elemental.trailEmitter = MakeStaffTrailEmitter(RED);
+        break;
+    case ElementalType::Ice:
+        elemental.emitter = MakeElementalAuraEmitter(WHITE, world->elementalRange, TILE_SIZE);
+        elemental.trailEmitter = MakeStaffTrailEmitter(WHITE);
+        break;
+    case ElementalType::Spring:
+        elemental.emitter = MakeElementalAuraEmitter(GREEN, world->elementalRange, TILE_SIZE);
+        break;
+    default:
+        break;
+    }
+}
 
-    auto data = LoadDataMatrix(worldPath, width, height);
-    auto entities = LoadDataMatrix(entitiesPath, width, height);
-    // Load tutorials if the file exists
-    world->tutorialTexts = LoadTutorialText(tutorialPath);
-    world->width = width;
-    world->height = height;
+// Bytes the world allocates for a level, so its arena takes a single block
+static size_t GetWorldArenaSize(int width, int height, size_t blocks, size_t elementals)
+{
+    size_t row = 3 * (sizeof(std::pmr::vector<int>) + alignof(std::max_align_t)) +
+                 width * (sizeof(Color) + sizeof(TileType) + sizeof(TileState));
+#if defined(ENABLE_TILE_STATE_VALIDATION)
+    row += sizeof(std::pmr::vector<float>) + alignof(std::max_align_t) + width * sizeof(float);
+#endif
+    size_t chunks = static_cast<size_t>(width / WORLD_CHUNK_SIZE + 1) * (height / WORLD_CHUNK_SIZE + 1);
+    return height * row + blocks * sizeof(Block) + elementals * sizeof(Elemental) + (chunks / 64 + 1) * sizeof(uint64_t) +
+           ParticleSystem::GetMaxBudget() * sizeof(Particle) + WORLD_ARENA_SLACK;
+}
+
+#if defined(ENABLE_TILE_STATE_VALIDATION)
+// The float states start from the stored ones, so only what the steps do is compared
+static void SyncReferenceStates(World *world)
+{
+    world->referenceStates.resize(world->height, std::pmr::vector<float>(world->width));
+    for (int y = 0; y < world->height; y++)
+    {
+        std::transform(world->tileStates[y].begin(), world->tileStates[y].end(), world->referenceStates[y].begin(),
+                       FromTileState);
+    }
+}
+#endif
 
-    world->tiles.resize(height, std::vector<Color>(width));
-    world->tileTypes.resize(height, std::vector<TileType>(width));
-    world->tileStates.resize(height, std::vector<float>(width));
+World *CreateWorld(int level, const LevelMatrix &data, const LevelMatrix &entities)
+{
+    int height = static_cast<int>(data.size());
+    int width = height > 0 ? static_cast<int>(data[0].size()) : 0;
 
-    world->playerTexture = GetTextureFromPath(player_texture_path);
-    world->groundTexture = GetTextureFromPath(ground_texture_path);
-    world->springStaffTexture = GetTextureFromPath("resources/spring_staff.png");
-    world->fireElementalTexture = GetTextureFromPath("resources/fire_elemental_free.png");
-    world->iceElementalTexture = GetTextureFromPath("resources/ice_elemental_free.png");
-    world->fireElementalCaptiveTexture = GetTextureFromPath("resources/fire_elemental_captive.png");
-    world->iceElementalCaptiveTexture = GetTextureFromPath("resources/ice_elemental_captive.png");
-    world->blockTexture = GetTextureFromPath("resources/block.png");
+    size_t blockCount = 0;
+    size_t elementalCount = 0;
+    for (int y = 0; y < height; y++)
+    {
+        blockCount += std::count(data[y].begin(), data[y].end(), 3);
+        if (y < static_cast<int>(entities.size()))
+        {
+            elementalCount += std::count_if(entities[y].begin(), entities[y].end(), [](int entity) {
+                return entity >= 2 && entity <= 6;
+            });
+        }
+    }
 
-    world->fireStaffTexture = GetTextureFromPath("resources/fire_staff.png");
-    world->iceStaffTexture = GetTextureFromPath("resources/ice_staff.png");
+    auto world = new World(GetWorldArenaSize(width, height, blockCount, elementalCount));
+    world->currentLevel = level;
+    world->width = width;
+    world->height = height;
+    SeedWorld(world, std::random_device{}());
 
-    world->fireGemTexture = GetTextureFromPath("resources/fire_gem.png");
-    world->iceGemTexture = GetTextureFromPath("resources/ice_gem.png");
+    world->tiles.resize(height, std::pmr::vector<Color>(width));
+    world->tileTypes.resize(height, std::pmr::vector<TileType>(width));
+    world->tileStates.resize(height, std::pmr::vector<TileState>(width));
+    world->blocks.reserve(blockCount);
+    world->elementals.reserve(elementalCount);
+    world->chunksX = (width + WORLD_CHUNK_SIZE - 1) / WORLD_CHUNK_SIZE;
+    world->chunksY = (height + WORLD_CHUNK_SIZE - 1) / WORLD_CHUNK_SIZE;
+    world->dirtyChunks.assign((world->chunksX * world->chunksY + 63) / 64, 0);
 
-    int numBlocks = 0;
     for (int y = 0; y < world->height; y++)
     {
         for (int x = 0; x < world->width; x++)
@@ -191,32 +251,36 @@ World *LoadWorld(int level,
             case 0:
                 world->tiles[y][x] = dry_color;
                 world->tileTypes[y][x] = TileType::Dry;
-                world->tileStates[y][x] = 0.0f;
+                world->tileStates[y][x] = ToTileState(0.0f);
                 break;
             case 1:
                 world->tiles[y][x] = grass_color;
                 world->tileTypes[y][x] = TileType::Grass;
-                world->tileStates[y][x] = 0.5f;
+                world->tileStates[y][x] = ToTileState(0.5f);
                 break;
             case 2:
                 world->tiles[y][x] = snow_color;
                 world->tileTypes[y][x] = TileType::Snow;
-                world->tileStates[y][x] = 1.0f;
+                world->tileStates[y][x] = ToTileState(1.0f);
                 break;
             case 3:
                 world->blocks.push_back({Vector2{x * TILE_SIZE, y * TILE_SIZE}});
                 world->tileTypes[y][x] = TileType::Block;
-                world->tileStates[y][x] = 0.5f;
-                numBlocks++;
+                world->tileStates[y][x] = ToTileState(0.5f);
                 break;
 
             default:
                 world->tiles[y][x] = RED;
                 world->tileTypes[y][x] = TileType::None;
-                world->tileStates[y][x] = 0.0f;
+                world->tileStates[y][x] = ToTileState(0.0f);
                 break;
             }
 
+            if (y >= static_cast<int>(entities.size()) || x >= static_cast<int>(entities[y].size()))
+            {
+                continue;
+            }
+
             auto entity = entities[y][x];
 
             auto position = Vector2{x * TILE_SIZE + HALF_TILE_SIZE, y * TILE_SIZE + HALF_TILE_SIZE};
@@ -270,13 +334,96 @@ World *LoadWorld(int level,
         }
     }
 
-    std::cout << "Num blocks: " << numBlocks << std::endl;
+    for (auto &elemental : world->elementals)
+    {
+        AttachEmitters(world, elemental);
+    }
+    world->hitEmitter = MakePlayerBurstEmitter(RED, 2.0f, false);
+    world->healEmitter = MakePlayerBurstEmitter(GREEN, 3.0f, true);
+#if defined(ENABLE_TILE_STATE_VALIDATION)
+    SyncReferenceStates(world);
+#endif
+
+    return world;
+}
+
+void SeedWorld(World *world, uint32_t seed)
+{
+    world->random.seed(seed);
+    world->particleSystem.Seed(seed ^ 0x9e3779b9u);
+}
+
+World *LoadWorldData(int level,
+                     const std::string &worldPath,
+                     const std::string &entitiesPath,
+                     const std::string &tutorialPath)
+{
+    PROFILE_SCOPE("LoadWorldData");
+    int width = 0;
+    int height = 0;
+
+    // The matrices only live until the world is built. On the main thread (the N/L level
+    // switches, and restarts whose restore failed) they come from the frame arena
+    auto data = LoadDataMatrix(worldPath, width, height, FrameArena::Get());
+    auto entities = LoadDataMatrix(entitiesPath, width, height, FrameArena::Get());
+    auto world = CreateWorld(level, data, entities);
+    // Load tutorials if the file exists
+    auto tutorials = LoadTutorialText(tutorialPath);
+    world->tutorialTexts.assign(tutorials.begin(), tutorials.end());
+    world->pendingTextures.reserve(WORLD_TEXTURE_COUNT);
+
+    QueueTextureFromPath(world, &world->playerTexture, player_texture_path);
+    QueueTextureFromPath(world, &world->groundTexture, ground_texture_path);
+    QueueTextureFromPath(world, &world->springStaffTexture, "resources/spring_staff.png");
+    QueueTextureFromPath(world, &world->fireElementalTexture, "resources/fire_elemental_free.png");
+    QueueTextureFromPath(world, &world->iceElementalTexture, "resources/ice_elemental_free.png");
+    QueueTextureFromPath(world, &world->fireElementalCaptiveTexture, "resources/fire_elemental_captive.png");
+    QueueTextureFromPath(world, &world->iceElementalCaptiveTexture, "resources/ice_elemental_captive.png");
+    QueueTextureFromPath(world, &world->blockTexture, "resources/block.png");
+
+    QueueTextureFromPath(world, &world->fireStaffTexture, "resources/fire_staff.png");
+    QueueTextureFromPath(world, &world->iceStaffTexture, "resources/ice_staff.png");
+
+    QueueTextureFromPath(world, &world->fireGemTexture, "resources/fire_gem.png");
+    QueueTextureFromPath(world, &world->iceGemTexture, "resources/ice_gem.png");
+
+    std::cout << "Num blocks: " << world->blocks.size() << std::endl;
 
     return world;
 }
 
+bool UploadWorldTextures(World *world, double deadline)
+{
+    PROFILE_SCOPE("UploadWorldTextures");
+    while (!world->pendingTextures.empty())
+    {
+        auto &pending = world->pendingTextures.back();
+        *pending.texture = LoadTextureFromImage(pending.image);
+        UnloadImage(pending.image);
+        world->pendingTextures.pop_back();
+
+        if (GetTime() > deadline)
+        {
+            break;
+        }
+    }
+    return world->pendingTextures.empty();
+}
+
+World *LoadWorld(int level,
+                 const std::string &worldPath,
+                 const std::string &entitiesPath,
+                 const std::string &tutorialPath)
+{
+    FXManager::Init();
+    auto world = LoadWorldData(level, worldPath, entitiesPath, tutorialPath);
+    UploadWorldTextures(world, std::numeric_limits<double>::max());
+    return world;
+}
+
 void RenderVictoryWorld(World *world, Shader *distortionShader, Shader *entitiesShader)
 {
+    PROFILE_SCOPE("RenderVictoryWorld");
     // Render the player
     BeginMode2D(world->camera);
 
@@ -362,8 +509,9 @@ void RenderVictoryWorld(World *world, Shader *distortionShader, Shader *entities
     EndMode2D();
 }
 
-void RenderWorld(World *world, Shader *distortionShader, Shader *entitiesShader)
+void RenderWorld(World *world, Shader *distortionShader, Shader *entitiesShader, Shader *particlesShader)
 {
+    PROFILE_SCOPE("RenderWorld");
 
     if (VictoryCondition(world))
     {
@@ -460,7 +608,9 @@ void RenderWorld(World *world, Shader *distortionShader, Shader *entitiesShader)
         }
     }
 
+    BeginShaderMode(*particlesShader);
     world->particleSystem.Draw();
+    EndShaderMode();
 
     // Draw a health bar for the player
     if (world->player.mortalEntity.health != world->player.mortalEntity.initialHealth)
@@ -504,106 +654,48 @@ void RenderGrabbingStaff(World *world, Shader *entitiesShader)
     if (!world->grabbingFireStaff && !world->grabbingIceStaff)
         return;
 
-    Vector2 mousePosition = GetMousePosition();
-    Vector2 worldMousePos = GetScreenToWorld2D(mousePosition, world->camera);
-
-    Texture2D *gem = nullptr;
-    if (world->grabbingFireStaff)
-    {
-        gem = &world->fireGemTexture;
-        for (auto &elemental : world->elementals)
-        {
-            if (elemental.type == ElementalType::Fire)
-            {
-                for (int i = 0; i < 3; ++i)
-                {
-                    if (GetRandomFloat(0.0f, 1.0f) > 0.5f)
-                    {
-                        Color subtleWhite = Fade(RED, 0.5f);
-                        world->particleSystem.Emit(worldMousePos, Vector2Subtract(elemental.position, worldMousePos), 5.0f, subtleWhite, 1.0f);
-                    }
-                }
-                elemental.ChoosenPosition = worldMousePos;
-            }
-        }
-    }
-    else if (world->grabbingIceStaff)
-    {
-        gem = &world->iceGemTexture;
-        for (auto &elemental : world->elementals)
-        {
-            if (elemental.type == ElementalType::Ice)
-            {
-                for (int i = 0; i < 3; ++i)
-                {
-                    if (GetRandomFloat(0.0f, 1.0f) > 0.5f)
-                    {
-                        Color subtleWhite = Fade(WHITE, 0.5f);
-                        world->particleSystem.Emit(worldMousePos, Vector2Subtract(elemental.position, worldMousePos), 5.0f, subtleWhite, 1.0f);
-                    }
-                }
-                elemental.ChoosenPosition = worldMousePos;
-            }
-        }
-    }
+    Texture2D *gem = world->grabbingFireStaff ? &world->fireGemTexture : &world->iceGemTexture;
 
     BeginShaderMode(*entitiesShader);
     Vector4 tintVector = {1, 1, 1, 1};
     SetShaderValue(*entitiesShader, GetShaderLocation(*entitiesShader, "tint"), &tintVector, SHADER_UNIFORM_VEC4);
-    auto pos = Vector2{worldMousePos.x - 7, worldMousePos.y - 7};
-    DrawTexture(*gem, pos.x, pos.y, WHITE);
-    world->gemPosition = pos;
+    DrawTexture(*gem, world->gemPosition.x, world->gemPosition.y, WHITE);
     EndShaderMode();
 }
 
-void EmitParticlesFromElementals(float deltaTime, World *world)
+// The grabbed staff follows the pointer and calls the elementals of its type
+void UpdateGrabbingStaff(World *world, float deltaTime)
 {
-    static float particleTimer = 0.0f;
-    particleTimer += deltaTime;
+    if (!world->grabbingFireStaff && !world->grabbingIceStaff)
+        return;
 
-    if (particleTimer >= 0.3f)
+    Vector2 pointer = world->input.pointer;
+    ElementalType calledType = world->grabbingFireStaff ? ElementalType::Fire : ElementalType::Ice;
+    for (auto &elemental : world->elementals)
     {
-        particleTimer = 0.0f;
-
-        for (auto &elemental : world->elementals)
+        if (elemental.type == calledType)
         {
-            if (elemental.type == ElementalType::None ||
-                elemental.type == ElementalType::FireStaff ||
-                elemental.type == ElementalType::IceStaff ||
-                elemental.status == ElementalStatus::Grabbed)
-                continue;
-            auto randomValue = GetRandomFloat(0.0f, 1.0f);
-            if (randomValue > 0.5f)
-                continue;
-
-            int minX = std::max(0, static_cast<int>(elemental.position.x / TILE_SIZE) - world->elementalRange);
-            int maxX = std::min(world->width - 1, static_cast<int>(elemental.position.x / TILE_SIZE) + world->elementalRange);
-            int minY = std::max(0, static_cast<int>(elemental.position.y / TILE_SIZE) - world->elementalRange);
-            int maxY = std::min(world->height - 1, static_cast<int>(elemental.position.y / TILE_SIZE) + world->elementalRange);
+            UpdateEmitter(elemental.trailEmitter, world->particleSystem, pointer, deltaTime, elemental.position);
+            elemental.ChoosenPosition = pointer;
+        }
+    }
+    world->gemPosition = Vector2{pointer.x - 7, pointer.y - 7};
+}
 
-            for (int y = minY; y <= maxY; ++y)
-            {
-                for (int x = minX; x <= maxX; ++x)
-                {
+void EmitParticlesFromElementals(float deltaTime, World *world)
+{
+    for (auto &elemental : world->elementals)
+    {
+        if (elemental.status == ElementalStatus::Grabbed)
+            continue;
 
-                    randomValue = GetRandomFloat(0.0f, 1.0f);
-                    if (randomValue > 0.5f)
-                        continue;
-                    Vector2 targetPos = {x * TILE_SIZE + TILE_SIZE / 2.0f, y * TILE_SIZE + TILE_SIZE / 2.0f};
-                    Vector2 velocity = Vector2Subtract(targetPos, elemental.position);
-                    velocity = Vector2Scale(Vector2Normalize(velocity), 50.0f * randomValue);
-                    Color color = (elemental.type == ElementalType::Fire) ? RED : (elemental.type == ElementalType::Ice) ? WHITE
-                                                                                                                         : GREEN;
-                    color.a = 255 * randomValue;
-                    world->particleSystem.Emit(elemental.position, velocity, 5.0f, color, 1.0f);
-                }
-            }
-        }
+        UpdateEmitter(elemental.emitter, world->particleSystem, elemental.position, deltaTime);
     }
 }
 
 void UpdateWorldState(World *world, float deltaTime)
 {
+    PROFILE_SCOPE("UpdateWorldState");
     for (const auto &elemental : world->elementals)
     {
         if (elemental.type == ElementalType::None)
@@ -616,6 +708,13 @@ void UpdateWorldState(World *world, float deltaTime)
         int maxX = std::min(world->width, static_cast<int>(elementalTilePos.x) + world->elementalRange + 1);
         int minY = std::max(0, static_cast<int>(elementalTilePos.y) - world->elementalRange);
         int maxY = std::min(world->height, static_cast<int>(elementalTilePos.y) + world->elementalRange + 1);
+        MarkDirtyTiles(world, minX, minY, maxX, maxY);
+        // Rounding of the fixed point states, the float ones don't use it
+        uint32_t dither = 0;
+        if constexpr (TILE_STATE_QUANTIZED)
+        {
+            dither = static_cast<uint32_t>(world->random());
+        }
 
         for (int y = minY; y < maxY; ++y)
         {
@@ -627,7 +726,7 @@ void UpdateWorldState(World *world, float deltaTime)
                     continue;
                 influence = influence * influence / (world->elementalRange * world->elementalRange) * world->elementalPower;
 
-                float current = world->tileStates[y][x];
+                float current = FromTileState(world->tileStates[y][x]);
                 TileType tileType = world->tileTypes[y][x];
                 float targetState;
                 float rangeDelta;
@@ -667,7 +766,13 @@ void UpdateWorldState(World *world, float deltaTime)
                 if (world->tileTypes[y][x] != TileType::Block)
                 {
                     float t = deltaTime * influence / (rangeDelta + 1e-6);
-                    world->tileStates[y][x] = Lerp(current, targetState, t);
+                    world->tileStates[y][x] = LerpTileState(world->tileStates[y][x], ToTileState(targetState), t,
+                                                            NextTileDither(dither));
+#if defined(ENABLE_TILE_STATE_VALIDATION)
+                    float &reference = world->referenceStates[y][x];
+                    reference = Lerp(reference, targetState, deltaTime * influence / (abs(reference - targetState) + 1e-6));
+#endif
+                    COUNTER_ADD(Counter::TilesTouched, 1);
                 }
             }
         }
@@ -679,12 +784,24 @@ void UpdateWorldState(World *world, float deltaTime)
 
 void UpdateTileStates(World *world, float deltaTime)
 {
+    PROFILE_SCOPE("UpdateTileStates");
     int numGrassTiles = 0;
+    // Same tests as on the float states, made on the stored ones
+    TileState dryMax = GetTileStateBound(dry_range.y);
+    TileState grassMax = GetTileStateBound(grass_range.y);
+    TileState snowMax = GetTileStateBound(snow_range.y);
+    // Every tile is classified, but after the first pass the types only change where
+    // UpdateWorldState marked tiles dirty. The rewind history relies on it to diff only the
+    // dirty chunks, so the first pass marks the whole map
+    if (!world->firstTileComputed)
+    {
+        MarkDirtyTiles(world, 0, 0, world->width, world->height);
+    }
     for (int y = 0; y < world->height; y++)
     {
         for (int x = 0; x < world->width; x++)
         {
-            float tileState = world->tileStates[y][x];
+            TileState tileState = world->tileStates[y][x];
             TileType currentType = world->tileTypes[y][x];
             TileType newType = currentType;
 
@@ -694,17 +811,17 @@ void UpdateTileStates(World *world, float deltaTime)
                 continue;
             }
 
-            if (tileState <= dry_range.y)
+            if (tileState <= dryMax)
             {
                 world->tiles[y][x] = dry_color;
                 newType = TileType::Dry;
             }
-            else if (tileState <= grass_range.y)
+            else if (tileState <= grassMax)
             {
                 world->tiles[y][x] = grass_color;
                 newType = TileType::Grass;
             }
-            else if (tileState <= snow_range.y)
+            else if (tileState <= snowMax)
             {
                 world->tiles[y][x] = snow_color;
                 newType = TileType::Snow;
@@ -714,9 +831,22 @@ void UpdateTileStates(World *world, float deltaTime)
             {
                 numGrassTiles++;
             }
+#if defined(ENABLE_TILE_STATE_VALIDATION)
+            float reference = world->referenceStates[y][x];
+            int band = (tileState > dryMax) + (tileState > grassMax);
+            int referenceBand = (reference > dry_range.y) + (reference > grass_range.y);
+            world->tileStateDrift.bandMismatches += band != referenceBand;
+            world->tileStateDrift.tilesClassified++;
+            // The float states overshoot the targets a little, the stored ones stop at 0 and 1
+            float error = std::abs(std::clamp(FromTileState(tileState), 0.0f, 1.0f) - std::clamp(reference, 0.0f, 1.0f));
+            world->tileStateDrift.maxError = std::max(world->tileStateDrift.maxError, error);
+#endif
 
             if (newType != currentType)
             {
+                COUNTER_ADD(newType == TileType::Dry     ? Counter::TransitionsToDry
+                            : newType == TileType::Grass ? Counter::TransitionsToGrass
+                                                         : Counter::TransitionsToSnow, 1);
                 world->tileTypes[y][x] = newType;
                 if (world->firstTileComputed)
                 {
@@ -725,6 +855,7 @@ void UpdateTileStates(World *world, float deltaTime)
             }
         }
     }
+    COUNTER_ADD(Counter::TilesClassified, world->width * world->height);
     world->springDominance = static_cast<float>(numGrassTiles) / (world->width * world->height);
     world->springTiles = numGrassTiles;
     world->firstTileComputed = true;
@@ -781,7 +912,10 @@ void HandleInteractionWithElementals(World *world)
                 break;
             }
         }
-        SoundManager::PlaySound(SFX_RELEASE, 0.3f, 0.1f);
+        if (world->events)
+        {
+            world->events->OnElementalReleased(world);
+        }
     }
 
     else
@@ -813,7 +947,10 @@ void HandleInteractionWithElementals(World *world)
         {
             closestElemental->status = ElementalStatus::Grabbed;
             world->player.status = PlayerStatus::Grabbing;
-            SoundManager::PlaySound(SFX_GRAB, 0.3f, 0.1f);
+            if (world->events)
+            {
+                world->events->OnElementalGrabbed(world, *closestElemental);
+            }
 
             if (closestElemental->type == ElementalType::FireStaff)
             {
@@ -874,29 +1011,13 @@ void UpdatePlayerHealth(World *world, float deltaTime)
 
 void UpdatePlayer(World *world, float deltaTime)
 {
+    PROFILE_SCOPE("UpdatePlayer");
     if (world->player.mortalEntity.isDead ||
         world->player.status == PlayerStatus::Idle)
         return;
 
-    float directionX = 0.0f;
-    float directionY = 0.0f;
-
-    if (IsKeyDown(KEY_RIGHT) || IsKeyDown(KEY_D))
-    {
-        directionX += 1.0f;
-    }
-    if (IsKeyDown(KEY_LEFT) || IsKeyDown(KEY_A))
-    {
-        directionX -= 1.0f;
-    }
-    if (IsKeyDown(KEY_DOWN) || IsKeyDown(KEY_S))
-    {
-        directionY += 1.0f;
-    }
-    if (IsKeyDown(KEY_UP) || IsKeyDown(KEY_W))
-    {
-        directionY -= 1.0f;
-    }
+    float directionX = Clamp(world->input.move.x, -1.0f, 1.0f);
+    float directionY = Clamp(world->input.move.y, -1.0f, 1.0f);
 
     float length = sqrtf(directionX * directionX + directionY * directionY);
     if (length != 0.0f)
@@ -931,7 +1052,7 @@ void UpdatePlayer(World *world, float deltaTime)
     world->player.position.x = Clamp(world->player.position.x, 0.0f, (world->width - 1) * TILE_SIZE);
     world->player.position.y = Clamp(world->player.position.y, 0.0f, (world->height - 1) * TILE_SIZE);
 
-    if (IsKeyReleased(KEY_SPACE))
+    if (world->input.interact)
     {
         HandleInteractionWithElementals(world);
     }
@@ -942,13 +1063,43 @@ void UpdatePlayer(World *world, float deltaTime)
 void UpdateCamera(World *world, float deltaTime)
 {
     world->camera.target = world->player.position;
-    world->camera.offset = Vector2{GetScreenWidth() / 2.0f, GetScreenHeight() / 2.0f};
+    world->camera.offset = Vector2{world->viewSize.x / 2.0f, world->viewSize.y / 2.0f};
     world->camera.rotation = 0.0f;
     world->camera.zoom = 1.0f;
+
+    Vector2 viewOrigin = GetScreenToWorld2D(Vector2{0, 0}, world->camera);
+    world->particleSystem.SetView(Rectangle{viewOrigin.x, viewOrigin.y,
+                                            world->viewSize.x / world->camera.zoom,
+                                            world->viewSize.y / world->camera.zoom});
+}
+
+WorldInput ReadWorldInput(const World *world)
+{
+    WorldInput input;
+    if (IsKeyDown(KEY_RIGHT) || IsKeyDown(KEY_D))
+    {
+        input.move.x += 1.0f;
+    }
+    if (IsKeyDown(KEY_LEFT) || IsKeyDown(KEY_A))
+    {
+        input.move.x -= 1.0f;
+    }
+    if (IsKeyDown(KEY_DOWN) || IsKeyDown(KEY_S))
+    {
+        input.move.y += 1.0f;
+    }
+    if (IsKeyDown(KEY_UP) || IsKeyDown(KEY_W))
+    {
+        input.move.y -= 1.0f;
+    }
+    input.interact = IsKeyReleased(KEY_SPACE);
+    input.pointer = GetScreenToWorld2D(GetMousePosition(), world->camera);
+    return input;
 }
 
 void UpdateElementals(World *world, float deltaTime)
 {
+    PROFILE_SCOPE("UpdateElementals");
     for (auto &elemental : world->elementals)
     {
         if (elemental.type == ElementalType::None)
@@ -999,7 +1150,7 @@ void UpdateElementals(World *world, float deltaTime)
             float minY = std::max(0.0f, elemental.position.y - elemental.movementRadius * TILE_SIZE);
             float maxY = std::min((world->height - 1) * TILE_SIZE, elemental.position.y + elemental.movementRadius * TILE_SIZE);
 
-            elemental.ChoosenPosition = GetRandomVector(minX, minY, maxX, maxY);
+            elemental.ChoosenPosition = GetRandomVector(world->random, minX, minY, maxX, maxY);
 
             if (--elemental.timesUntilMovementIncrease <= 0)
             {
@@ -1010,9 +1161,185 @@ void UpdateElementals(World *world, float deltaTime)
     }
 }
 
+// FNV-1a over the raw bytes, floats are hashed by their bits so any difference shows up
+static void HashBytes(uint64_t &hash, const void *data, size_t size)
+{
+    auto bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    }
+}
+
+template <typename T>
+static void HashValue(uint64_t &hash, const T &value)
+{
+    HashBytes(hash, &value, sizeof(value));
+}
+
+uint64_t HashWorld(const World *world)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    HashValue(hash, world->width);
+    HashValue(hash, world->height);
+    for (int y = 0; y < world->height; y++)
+    {
+        HashBytes(hash, world->tileTypes[y].data(), world->tileTypes[y].size() * sizeof(TileType));
+        HashBytes(hash, world->tileStates[y].data(), world->tileStates[y].size() * sizeof(TileState));
+    }
+
+    const auto &player = world->player;
+    HashValue(hash, player.position.x);
+    HashValue(hash, player.position.y);
+    HashValue(hash, player.status);
+    HashValue(hash, player.mortalEntity.health);
+    HashValue(hash, player.mortalEntity.nextHealthCheck);
+    HashValue(hash, player.mortalEntity.isDead);
+
+    for (const auto &elemental : world->elementals)
+    {
+        HashValue(hash, elemental.position.x);
+        HashValue(hash, elemental.position.y);
+        HashValue(hash, elemental.type);
+        HashValue(hash, elemental.status);
+        HashValue(hash, elemental.movementRadius);
+        HashValue(hash, elemental.ChoosenPosition.x);
+        HashValue(hash, elemental.ChoosenPosition.y);
+    }
+
+    HashValue(hash, world->springTiles);
+    HashValue(hash, world->springDominance);
+    HashValue(hash, world->grabbingFireStaff);
+    HashValue(hash, world->grabbingIceStaff);
+    HashValue(hash, world->timeInVictory);
+    return hash;
+}
+
+void SaveWorld(const World *world, WorldSnapshot &snapshot)
+{
+    PROFILE_SCOPE("SaveWorld");
+    snapshot.level = world->currentLevel;
+    snapshot.width = world->width;
+    snapshot.height = world->height;
+
+    size_t area = static_cast<size_t>(world->width) * world->height;
+    snapshot.tiles.resize(area);
+    snapshot.tileTypes.resize(area);
+    snapshot.tileStates.resize(area);
+    for (int y = 0; y < world->height; y++)
+    {
+        size_t row = static_cast<size_t>(y) * world->width;
+        std::copy(world->tiles[y].begin(), world->tiles[y].end(), snapshot.tiles.begin() + row);
+        std::copy(world->tileTypes[y].begin(), world->tileTypes[y].end(), snapshot.tileTypes.begin() + row);
+        std::copy(world->tileStates[y].begin(), world->tileStates[y].end(), snapshot.tileStates.begin() + row);
+    }
+    snapshot.elementals.assign(world->elementals.begin(), world->elementals.end());
+
+    snapshot.player = world->player;
+    snapshot.input = world->input;
+    snapshot.random = world->random;
+    snapshot.camera = world->camera;
+    snapshot.elementalPower = world->elementalPower;
+    snapshot.elementalRange = world->elementalRange;
+    snapshot.springTiles = world->springTiles;
+    snapshot.springDominance = world->springDominance;
+    snapshot.firstTileComputed = world->firstTileComputed;
+    snapshot.grabbingFireStaff = world->grabbingFireStaff;
+    snapshot.grabbingIceStaff = world->grabbingIceStaff;
+    snapshot.gemPosition = world->gemPosition;
+    snapshot.timeInVictory = world->timeInVictory;
+    snapshot.wasInVictory = world->wasInVictory;
+
+    snapshot.hitEmitter = world->hitEmitter;
+    snapshot.healEmitter = world->healEmitter;
+    world->particleSystem.SaveState(snapshot.particles);
+}
+
+bool RestoreWorld(World *world, const WorldSnapshot &snapshot)
+{
+    PROFILE_SCOPE("RestoreWorld");
+    // The elementals never come and go, their storage was sized for the level
+    if (snapshot.level != world->currentLevel || snapshot.width != world->width ||
+        snapshot.height != world->height || snapshot.elementals.size() != world->elementals.size())
+    {
+        return false;
+    }
+
+    for (int y = 0; y < world->height; y++)
+    {
+        size_t row = static_cast<size_t>(y) * world->width;
+        std::copy_n(snapshot.tiles.begin() + row, world->width, world->tiles[y].begin());
+        std::copy_n(snapshot.tileTypes.begin() + row, world->width, world->tileTypes[y].begin());
+        std::copy_n(snapshot.tileStates.begin() + row, world->width, world->tileStates[y].begin());
+    }
+    std::copy(snapshot.elementals.begin(), snapshot.elementals.end(), world->elementals.begin());
+
+    world->player = snapshot.player;
+    world->input = snapshot.input;
+    world->random = snapshot.random;
+    world->camera = snapshot.camera;
+    world->elementalPower = snapshot.elementalPower;
+    world->elementalRange = snapshot.elementalRange;
+    world->springTiles = snapshot.springTiles;
+    world->springDominance = snapshot.springDominance;
+    world->firstTileComputed = snapshot.firstTileComputed;
+    world->grabbingFireStaff = snapshot.grabbingFireStaff;
+    world->grabbingIceStaff = snapshot.grabbingIceStaff;
+    world->gemPosition = snapshot.gemPosition;
+    world->timeInVictory = snapshot.timeInVictory;
+    world->wasInVictory = snapshot.wasInVictory;
+
+    world->hitEmitter = snapshot.hitEmitter;
+    world->healEmitter = snapshot.healEmitter;
+    world->particleSystem.RestoreState(snapshot.particles);
+    MarkDirtyTiles(world, 0, 0, world->width, world->height);
+#if defined(ENABLE_TILE_STATE_VALIDATION)
+    SyncReferenceStates(world);
+#endif
+    return true;
+}
+
+void MarkDirtyTiles(World *world, int minX, int minY, int maxX, int maxY)
+{
+    if (minX >= maxX || minY >= maxY)
+    {
+        return;
+    }
+    for (int chunkY = minY / WORLD_CHUNK_SIZE; chunkY <= (maxY - 1) / WORLD_CHUNK_SIZE; chunkY++)
+    {
+        for (int chunkX = minX / WORLD_CHUNK_SIZE; chunkX <= (maxX - 1) / WORLD_CHUNK_SIZE; chunkX++)
+        {
+            int chunk = chunkY * world->chunksX + chunkX;
+            world->dirtyChunks[chunk / 64] |= uint64_t{1} << (chunk % 64);
+        }
+    }
+}
+
+void ClearDirtyChunks(World *world)
+{
+    std::fill(world->dirtyChunks.begin(), world->dirtyChunks.end(), 0);
+}
+
+Color GetTileColor(TileType type)
+{
+    switch (type)
+    {
+    case TileType::Dry:
+        return dry_color;
+    case TileType::Grass:
+        return grass_color;
+    case TileType::Snow:
+        return snow_color;
+    case TileType::Block:
+        return Color{};
+    default:
+        return RED;
+    }
+}
+
 void UpdateWorld(World *world, float deltaTime)
 {
-    FXManager::Update(deltaTime);
+    PROFILE_SCOPE("UpdateWorld");
 
     if (VictoryCondition(world))
     {
@@ -1021,6 +1348,7 @@ void UpdateWorld(World *world, float deltaTime)
     }
 
     UpdatePlayer(world, deltaTime);
+    UpdateGrabbingStaff(world, deltaTime);
     UpdateWorldState(world, deltaTime);
     UpdateElementals(world, deltaTime);
     UpdateTileStates(world, deltaTime);
@@ -1037,77 +1365,36 @@ void DeleteWorld(World *world)
     if (!world)
         return;
 
-    UnloadTexture(world->playerTexture);
-    UnloadTexture(world->groundTexture);
-    UnloadTexture(world->springStaffTexture);
-    UnloadTexture(world->iceElementalTexture);
-    UnloadTexture(world->iceElementalCaptiveTexture);
-    UnloadTexture(world->fireElementalTexture);
-    UnloadTexture(world->fireElementalCaptiveTexture);
-    UnloadTexture(world->springStaffTexture);
-    UnloadTexture(world->blockTexture);
-    UnloadTexture(world->fireStaffTexture);
-    UnloadTexture(world->iceStaffTexture);
-    UnloadTexture(world->fireGemTexture);
-    UnloadTexture(world->iceGemTexture);
-    FXManager::Cleanup();
+    for (auto &pending : world->pendingTextures)
+    {
+        UnloadImage(pending.image);
+    }
+
+    // Headless worlds have no textures (and no GL context to unload them from)
+    for (auto texture : {&world->playerTexture, &world->groundTexture, &world->springStaffTexture,
+                         &world->iceElementalTexture, &world->iceElementalCaptiveTexture,
+                         &world->fireElementalTexture, &world->fireElementalCaptiveTexture,
+                         &world->blockTexture, &world->fireStaffTexture, &world->iceStaffTexture,
+                         &world->fireGemTexture, &world->iceGemTexture})
+    {
+        if (texture->id != 0)
+        {
+            UnloadTexture(*texture);
+        }
+    }
     delete world;
 }
 
 void NotifyStateChange(World *world, Rectangle where, TileType from, TileType to)
 {
+    if (!world->events)
+        return;
+
     where.x *= TILE_SIZE;
     where.y *= TILE_SIZE;
     where.width *= TILE_SIZE;
     where.height *= TILE_SIZE;
-    FXManager::AddFadeRect(where, WHITE, 0.5f, true);
-
-    switch (to)
-    {
-    case TileType::Dry:
-        SoundManager::PlaySound(SFX_DRY, 0.3f, 0.1f);
-        break;
-    case TileType::Grass:
-        SoundManager::PlaySound(SFX_GRASS, 0.1f, 0.5f);
-        break;
-    case TileType::Snow:
-        SoundManager::PlaySound(SFX_FREEZE, 0.3f, 0.1f);
-        break;
-    case TileType::Block:
-        break;
-    default:
-        break;
-    }
-}
-
-void EmitParticlesAroundPlayer(World *w, Vector2 playerPosition, int numParticles, float particleRadius, Color color, float lifeTime, bool from)
-{
-    float angle, distance, speed;
-    Vector2 emitPosition, velocity;
-
-    for (int i = 0; i < numParticles; i++)
-    {
-        angle = GetRandomValue(0, 360) * DEG2RAD;
-        distance = GetRandomValue(10, 50);
-
-        emitPosition.x = playerPosition.x + cos(angle) * distance;
-        emitPosition.y = playerPosition.y + sin(angle) * distance;
-
-        speed = GetRandomValue(200, 400) / 100.0f;
-
-        if (from)
-        {
-            velocity.x = (emitPosition.x - playerPosition.x) * speed;
-            velocity.y = (emitPosition.y - playerPosition.y) * speed;
-        }
-        else
-        {
-            velocity.x = (playerPosition.x - emitPosition.x) * speed;
-            velocity.y = (playerPosition.y - emitPosition.y) * speed;
-        }
-
-        w->particleSystem.Emit(emitPosition, velocity, particleRadius, color, lifeTime);
-    }
+    world->events->OnTileChanged(world, where, from, to);
 }
 
 void NotifyPlayerHealthChange(World *world, float lastHealth, float newHealth)
@@ -1115,15 +1402,16 @@ void NotifyPlayerHealthChange(World *world, float lastHealth, float newHealth)
     Vector2 centeredPlayerPos = GetPlayerCenter(world);
     if (newHealth < lastHealth)
     {
-        FXManager::AddFadeRect(Rectangle{0, 0, static_cast<float>(GetScreenWidth()), static_cast<float>(GetScreenHeight())}, RED, 0.025f, false);
-        EmitParticlesAroundPlayer(world, centeredPlayerPos, 10, 2.0f, RED, 0.7f, true);
-        SoundManager::PlaySound(SFX_HIT, 0.3f, 0.1f);
+        EmitBurst(world->hitEmitter, world->particleSystem, centeredPlayerPos, world->hitEmitter.burstCount);
     }
     else
     {
-        // FXManager::AddFadeRect(Rectangle{0, 0, static_cast<float>(GetScreenWidth()), static_cast<float>(GetScreenHeight())}, GREEN, 0.025f, false);
-        EmitParticlesAroundPlayer(world, centeredPlayerPos, 10, 3.0f, GREEN, 0.7f, false);
-        SoundManager::PlaySound(SFX_HEAL, 0.3f, 0.1f);
+        EmitBurst(world->healEmitter, world->particleSystem, centeredPlayerPos, world->healEmitter.burstCount);
+    }
+
+    if (world->events)
+    {
+        world->events->OnPlayerHealthChanged(world, lastHealth, newHealth);
     }
 }
 
@@ -1139,9 +1427,11 @@ bool VictoryCondition(World *world)
     {
         if(victory)
         {
-            SoundManager::PlaySound(SFX_VICTORY, 0.3f, 0.1f);
             world->wasInVictory = true;
-            FXManager::AddFadeRect(Rectangle{0, 0, static_cast<float>(GetScreenWidth()), static_cast<float>(GetScreenHeight())}, GREEN, 0.025f, false);
+            if (world->events)
+            {
+                world->events->OnVictory(world);
+            }
         }
     }
     return victory;
@@ -3,7 +3,14 @@
 #include "raylib.h"
 #include <vector>
 #include <string>
+#include <random>
+#include <cstdint>
+#include <memory_resource>
+#include "constants.h"
+#include "Arena.h"
 #include "ParticleSystem.h"
+#include "ParticleEmitter.h"
+#include "TileState.h"
 
 #define TILE_SIZE 32.0f
 #define HALF_TILE_SIZE 16.0f
@@ -16,10 +23,21 @@ inline auto dry_range = Vector2{0.0f, 0.3f};
 inline auto grass_range = Vector2{0.3f, 0.7f};
 inline auto snow_range = Vector2{0.7f, 1.0f};
 
-std::vector<std::vector<int>> LoadDataMatrix(const std::string &path, int &width, int &height);
+// Rows of the values of a level CSV, all of the same width
+using LevelMatrix = std::pmr::vector<std::pmr::vector<int>>;
+
+LevelMatrix LoadDataMatrix(const std::string &path, int &width, int &height,
+                           std::pmr::memory_resource *resource = std::pmr::get_default_resource());
 
 inline constexpr int TIMES_INTIL_MOVEMENT_RADIUS_INCRESES = 20;
 
+// The game steps the world at a fixed rate so runs can be replayed exactly
+inline constexpr float WORLD_TIMESTEP = 1.0f / 60.0f;
+// Steps run in a single frame before the game gives up catching up
+inline constexpr int WORLD_MAX_STEPS_PER_FRAME = 5;
+// Side in tiles of the chunks the changed tiles are tracked by
+inline constexpr int WORLD_CHUNK_SIZE = 16;
+
 struct RegisteredWorld
 {
     int level;
@@ -100,6 +118,8 @@ struct Elemental
     int timesUntilMovementIncrease = TIMES_INTIL_MOVEMENT_RADIUS_INCRESES;
     Vector2 ChoosenPosition = {0, 0};
     ElementalStatus status = ElementalStatus::Moving;
+    ParticleEmitter emitter{};
+    ParticleEmitter trailEmitter{};
 };
 
 enum class GameStatus
@@ -122,21 +142,80 @@ struct Block
     Vector2 position;
 };
 
+// Player input for one simulation step. The game reads it from the keyboard and mouse
+// (ReadWorldInput), headless runs fill it from a script
+struct WorldInput
+{
+    Vector2 move = {0, 0};    // Each axis in [-1, 1]
+    bool interact = false;    // Grab or release the closest elemental
+    Vector2 pointer = {0, 0}; // World position the staff gem follows
+};
+
+struct World;
+
+// Receives what happens in the simulation. The game plays sounds and effects, headless runs
+// can ignore or count the events. The events come from the thread calling UpdateWorld
+class WorldEventSink
+{
+public:
+    virtual ~WorldEventSink() = default;
+    virtual void OnTileChanged(World *world, Rectangle where, TileType from, TileType to) {}
+    virtual void OnPlayerHealthChanged(World *world, float lastHealth, float newHealth) {}
+    virtual void OnElementalGrabbed(World *world, const Elemental &elemental) {}
+    virtual void OnElementalReleased(World *world) {}
+    virtual void OnVictory(World *world) {}
+};
+
+struct PendingTexture
+{
+    Texture2D *texture;
+    Image image;
+};
+
+#if defined(ENABLE_TILE_STATE_VALIDATION)
+// How far the stored tile states went from the float ones, since the world was created
+struct TileStateDrift
+{
+    // Tiles classified in another band than the float state would be, added up over the steps
+    uint64_t bandMismatches = 0;
+    uint64_t tilesClassified = 0;
+    float maxError = 0.0f;
+};
+#endif
+
 struct World
 {
+    // Everything the world allocates comes from its arena, so it has to be constructed first
+    Arena arena;
+
     int currentLevel = 1;
     int width = 0;
     int height = 0;
 
-    std::vector<std::vector<Color>> tiles;
-    std::vector<std::vector<TileType>> tileTypes;
-    std::vector<std::vector<float>> tileStates;
-    std::vector<Elemental> elementals;
-    std::vector<TutorialText> tutorialTexts;
-    std::vector<Block> blocks;
+    std::pmr::vector<std::pmr::vector<Color>> tiles;
+    std::pmr::vector<std::pmr::vector<TileType>> tileTypes;
+    std::pmr::vector<std::pmr::vector<TileState>> tileStates;
+    std::pmr::vector<Elemental> elementals;
+    std::pmr::vector<TutorialText> tutorialTexts;
+    std::pmr::vector<Block> blocks;
+#if defined(ENABLE_TILE_STATE_VALIDATION)
+    // The tile states updated with the float math from the same elementals and types
+    std::pmr::vector<std::pmr::vector<float>> referenceStates;
+    TileStateDrift tileStateDrift;
+#endif
+    // A bit per chunk whose tile states or types changed since ClearDirtyChunks, row after row
+    int chunksX = 0;
+    int chunksY = 0;
+    std::pmr::vector<uint64_t> dirtyChunks;
 
     Player player = Player();
 
+    WorldInput input;
+    WorldEventSink *events = nullptr;
+    std::mt19937 random;
+    // Size of the view in pixels, used to place the camera and cull particles
+    Vector2 viewSize = {static_cast<float>(SCREEN_WIDTH), static_cast<float>(SCREEN_HEIGHT)};
+
     Texture2D playerTexture{};
     Texture2D groundTexture{};
 
@@ -155,6 +234,9 @@ struct World
 
     Texture2D blockTexture{};
 
+    // Images decoded by LoadWorldData that still need to be uploaded to the GPU
+    std::pmr::vector<PendingTexture> pendingTextures;
+
     float elementalPower = 0.1f;
     int elementalRange = 4;
     Camera2D camera = {0};
@@ -162,6 +244,8 @@ struct World
     float springDominance = 0.0f;
 
     ParticleSystem particleSystem;
+    ParticleEmitter hitEmitter{};
+    ParticleEmitter healEmitter{};
     bool firstTileComputed = false;
 
     bool grabbingFireStaff = false;
@@ -172,21 +256,92 @@ struct World
     float timeInVictory = 0.0f;
 
     bool wasInVictory = false;
+
+    explicit World(size_t arenaCapacity)
+        : arena(arenaCapacity), tiles(&arena), tileTypes(&arena), tileStates(&arena), elementals(&arena),
+          tutorialTexts(&arena), blocks(&arena),
+#if defined(ENABLE_TILE_STATE_VALIDATION)
+          referenceStates(&arena),
+#endif
+          dirtyChunks(&arena), pendingTextures(&arena), particleSystem(&arena)
+    {
+    }
+};
+
+// Copy of the simulation state of a world: tiles, player, elementals, random generators and
+// particles. Taken right after loading it restarts the level without loading it again, taken
+// later it is a checkpoint. The layout (blocks, tutorials) and the textures are not in it, they
+// don't change while playing
+struct WorldSnapshot
+{
+    int level = 0;
+    int width = 0;
+    int height = 0;
+    // Row after row
+    std::vector<Color> tiles;
+    std::vector<TileType> tileTypes;
+    std::vector<TileState> tileStates;
+    std::vector<Elemental> elementals;
+
+    Player player;
+    WorldInput input;
+    std::mt19937 random;
+    Camera2D camera = {0};
+    float elementalPower = 0.0f;
+    int elementalRange = 0;
+    int springTiles = 0;
+    float springDominance = 0.0f;
+    bool firstTileComputed = false;
+    bool grabbingFireStaff = false;
+    bool grabbingIceStaff = false;
+    Vector2 gemPosition = {0, 0};
+    float timeInVictory = 0.0f;
+    bool wasInVictory = false;
+
+    ParticleEmitter hitEmitter{};
+    ParticleEmitter healEmitter{};
+    ParticleSystemState particles;
 };
 
+// Builds the simulation state from the ground and entities matrices, without textures.
+// The world's arena is sized for the level, deleting the world frees it in one go
+World *CreateWorld(int level, const LevelMatrix &ground, const LevelMatrix &entities);
+// Seeds the simulation and the particles random generators
+void SeedWorld(World *world, uint32_t seed);
+// CPU part of the loading (files, parsing and image decoding), it can run on a worker thread
+World *LoadWorldData(int level,
+                     const std::string &worldPath,
+                     const std::string &entitiesPath,
+                     const std::string &tutorialPath);
+// Uploads the pending textures until the deadline (GetTime() based) passes, returns true when all are uploaded
+bool UploadWorldTextures(World *world, double deadline);
 World *LoadWorld(int level,
                  const std::string &worldPath,
                  const std::string &entitiesPath,
                  const std::string &tutorialPath);
 void DeleteWorld(World *world);
 std::vector<TutorialText> LoadTutorialText(const std::string &path);
-void RenderWorld(World *world, Shader *distortionShader, Shader *entitiesShader);
+void RenderWorld(World *world, Shader *distortionShader, Shader *entitiesShader, Shader *particlesShader);
+WorldInput ReadWorldInput(const World *world);
 void UpdateWorld(World *world, float deltaTime);
 Vector2 GetTilePosition(const Vector2 &position);
+bool IsCollidingWithBlocks(World *world, Vector2 proposedPosition);
 void NotifyStateChange(World *world, Rectangle where, TileType from, TileType to);
 void NotifyPlayerHealthChange(World *world, float lastHealth, float newHealth);
 Vector2 GetPlayerCenter(World* world);
 
 void RenderGrabbingStaff(World* world, Shader *entitiesShader);
 
-bool VictoryCondition(World *world);
\ No newline at end of file
+bool VictoryCondition(World *world);
+// Hash of the simulation state (tiles, player, elementals), equal hashes mean equal worlds
+uint64_t HashWorld(const World *world);
+// Flags the chunks overlapping the tiles [minX, maxX) x [minY, maxY) as changed
+void MarkDirtyTiles(World *world, int minX, int minY, int maxX, int maxY);
+void ClearDirtyChunks(World *world);
+// Color the classification gives to a tile type
+Color GetTileColor(TileType type);
+// Copies the state into the snapshot, reusing its memory when it already held this level
+void SaveWorld(const World *world, WorldSnapshot &snapshot);
+// Puts the world back in the snapshot state, in place and without allocating. Fails when the
+// snapshot is of another level
+bool RestoreWorld(World *world, const WorldSnapshot &snapshot);
\ No newline at end of file
@@ -0,0 +1,54 @@
+// Converts sound effects and music to the cooked PCM format loaded by SoundManager.
+// Usage: cook_audio [--rate 48000] file1.wav file2.mp3 ...
+// Every input is written as resources/cooked/<name>.pcm, 16 bit, at the given rate.
+
+#include "raylib.h"
+#include "CookedAudio.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sys/stat.h>
+
+int main(int argc, char **argv)
+{
+    int sampleRate = 48000;
+    int cooked = 0;
+    int failed = 0;
+
+    SetTraceLogLevel(LOG_WARNING);
+    mkdir(COOKED_AUDIO_DIR, 0755);
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc)
+        {
+            sampleRate = atoi(argv[++i]);
+            continue;
+        }
+
+        Wave wave = LoadWave(argv[i]);
+        if (!IsWaveReady(wave))
+        {
+            std::cerr << "Unable to decode " << argv[i] << std::endl;
+            failed++;
+            continue;
+        }
+
+        WaveFormat(&wave, sampleRate, 16, wave.channels);
+        std::string output = GetCookedAudioPath(argv[i]);
+        if (SaveCookedAudio(output.c_str(), wave))
+        {
+            std::cout << argv[i] << " -> " << output << " (" << wave.frameCount << " frames, "
+                      << wave.channels << " channels, " << sampleRate << " Hz)" << std::endl;
+            cooked++;
+        }
+        else
+        {
+            failed++;
+        }
+        UnloadWave(wave);
+    }
+
+    std::cout << "Cooked " << cooked << " files, " << failed << " failed" << std::endl;
+    return failed == 0 ? 0 : 1;
+}
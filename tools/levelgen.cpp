@@ -0,0 +1,417 @@
+// Generates big levels in the resources/worlds format, for benchmarks and soak tests.
+// Usage: levelgen [--size N | --width W --height H] [--seed S] [--blocks 0.05] [--maze 0] [--braid 0.1]
+//                 [--snow 0.2] [--grass 0.05] [--fire N] [--ice N] [--spring N] [--no-staffs]
+//                 [--out resources/worlds/generated/level_gen]
+// Writes <out>_ground.csv, <out>_entities.csv and <out>_tutorial.txt. The same arguments
+// always give the same files.
+//
+//   --blocks  chance of a loose block on every free tile
+//   --maze    corridor width in tiles of a maze of blocks covering the level, 0 for none
+//   --braid   chance of removing each maze wall tile, to open loops in the maze
+//   --snow    part of the ground covered by snow patches, --grass the same for grass
+//   --fire/--ice/--spring  number of elementals, by default they grow with the level area
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+inline constexpr int MAX_LEVEL_SIZE = 4096;
+
+// Values of the ground and entities CSVs, as read by CreateWorld
+enum Ground : unsigned char
+{
+    GROUND_DRY = 0,
+    GROUND_GRASS = 1,
+    GROUND_SNOW = 2,
+    GROUND_BLOCK = 3
+};
+
+enum Entity : unsigned char
+{
+    ENTITY_NONE = 0,
+    ENTITY_PLAYER = 1,
+    ENTITY_FIRE = 2,
+    ENTITY_ICE = 3,
+    ENTITY_SPRING = 4,
+    ENTITY_FIRE_STAFF = 5,
+    ENTITY_ICE_STAFF = 6
+};
+
+struct LevelOptions
+{
+    int width = 64;
+    int height = 64;
+    uint32_t seed = 1;
+    float blocks = 0.05f;
+    int maze = 0;
+    float braid = 0.1f;
+    float snow = 0.2f;
+    float grass = 0.05f;
+    int fire = -1;
+    int ice = -1;
+    int spring = 1;
+    bool staffs = true;
+    std::string out = "resources/worlds/generated/level_gen";
+};
+
+struct Level
+{
+    int width;
+    int height;
+    std::vector<unsigned char> ground;
+    std::vector<unsigned char> entities;
+
+    unsigned char &GroundAt(int x, int y) { return ground[static_cast<size_t>(y) * width + x]; }
+    unsigned char &EntityAt(int x, int y) { return entities[static_cast<size_t>(y) * width + x]; }
+};
+
+// Recursive backtracker over cells of corridor x corridor tiles, separated by walls one tile thick
+static void CarveMaze(Level &level, int corridor, float braid, std::mt19937 &random)
+{
+    int step = corridor + 1;
+    int cellsX = (level.width - 1) / step;
+    int cellsY = (level.height - 1) / step;
+    if (cellsX < 1 || cellsY < 1)
+    {
+        return;
+    }
+
+    int mazeWidth = cellsX * step + 1;
+    int mazeHeight = cellsY * step + 1;
+    for (int y = 0; y < mazeHeight; y++)
+    {
+        for (int x = 0; x < mazeWidth; x++)
+        {
+            level.GroundAt(x, y) = GROUND_BLOCK;
+        }
+    }
+
+    auto openRect = [&](int left, int top, int width, int height) {
+        for (int y = top; y < top + height; y++)
+        {
+            for (int x = left; x < left + width; x++)
+            {
+                level.GroundAt(x, y) = GROUND_DRY;
+            }
+        }
+    };
+
+    std::vector<bool> visited(static_cast<size_t>(cellsX) * cellsY, false);
+    std::vector<int> stack;
+    stack.reserve(static_cast<size_t>(cellsX) * cellsY);
+    stack.push_back(0);
+    visited[0] = true;
+    openRect(1, 1, corridor, corridor);
+
+    const int offsets[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+    while (!stack.empty())
+    {
+        int cell = stack.back();
+        int cellX = cell % cellsX;
+        int cellY = cell / cellsX;
+
+        int candidates[4];
+        int count = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            int nextX = cellX + offsets[i][0];
+            int nextY = cellY + offsets[i][1];
+            if (nextX >= 0 && nextX < cellsX && nextY >= 0 && nextY < cellsY && !visited[nextY * cellsX + nextX])
+            {
+                candidates[count++] = i;
+            }
+        }
+
+        if (count == 0)
+        {
+            stack.pop_back();
+            continue;
+        }
+
+        int direction = candidates[std::uniform_int_distribution<int>(0, count - 1)(random)];
+        int nextX = cellX + offsets[direction][0];
+        int nextY = cellY + offsets[direction][1];
+        visited[nextY * cellsX + nextX] = true;
+        stack.push_back(nextY * cellsX + nextX);
+
+        // Open the next cell and the wall between both
+        openRect(1 + nextX * step, 1 + nextY * step, corridor, corridor);
+        int left = 1 + std::min(cellX, nextX) * step;
+        int top = 1 + std::min(cellY, nextY) * step;
+        if (offsets[direction][0] != 0)
+        {
+            openRect(left + corridor, top, 1, corridor);
+        }
+        else
+        {
+            openRect(left, top + corridor, corridor, 1);
+        }
+    }
+
+    // Inner walls only, the border of the maze stays closed
+    std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+    for (int y = 1; y < mazeHeight - 1; y++)
+    {
+        for (int x = 1; x < mazeWidth - 1; x++)
+        {
+            if (level.GroundAt(x, y) == GROUND_BLOCK && chance(random) < braid)
+            {
+                level.GroundAt(x, y) = GROUND_DRY;
+            }
+        }
+    }
+}
+
+// Round patches of a ground type until the wanted part of the level is covered
+static void PaintPatches(Level &level, unsigned char type, float coverage, std::mt19937 &random)
+{
+    size_t area = static_cast<size_t>(level.width) * level.height;
+    size_t wanted = static_cast<size_t>(coverage * area);
+    size_t painted = 0;
+    int maxRadius = std::max(1, std::min(level.width, level.height) / 16);
+
+    std::uniform_int_distribution<int> randomX(0, level.width - 1);
+    std::uniform_int_distribution<int> randomY(0, level.height - 1);
+    std::uniform_int_distribution<int> randomRadius(1, std::min(maxRadius, 24));
+
+    // Bounded, patches over blocks or over other patches don't count
+    for (size_t attempts = 0; painted < wanted && attempts < area; attempts++)
+    {
+        int centerX = randomX(random);
+        int centerY = randomY(random);
+        int radius = randomRadius(random);
+        for (int y = std::max(0, centerY - radius); y <= std::min(level.height - 1, centerY + radius); y++)
+        {
+            for (int x = std::max(0, centerX - radius); x <= std::min(level.width - 1, centerX + radius); x++)
+            {
+                int dx = x - centerX;
+                int dy = y - centerY;
+                if (dx * dx + dy * dy <= radius * radius && level.GroundAt(x, y) == GROUND_DRY)
+                {
+                    level.GroundAt(x, y) = type;
+                    painted++;
+                }
+            }
+        }
+    }
+}
+
+// Random free tile, or false if none was found after many tries
+static bool FindFreeTile(Level &level, std::mt19937 &random, int &outX, int &outY)
+{
+    std::uniform_int_distribution<int> randomX(0, level.width - 1);
+    std::uniform_int_distribution<int> randomY(0, level.height - 1);
+    for (int attempt = 0; attempt < 10000; attempt++)
+    {
+        int x = randomX(random);
+        int y = randomY(random);
+        if (level.GroundAt(x, y) != GROUND_BLOCK && level.EntityAt(x, y) == ENTITY_NONE)
+        {
+            outX = x;
+            outY = y;
+            return true;
+        }
+    }
+    return false;
+}
+
+static int PlaceEntities(Level &level, unsigned char entity, int count, std::mt19937 &random)
+{
+    int placed = 0;
+    int x = 0;
+    int y = 0;
+    for (; placed < count && FindFreeTile(level, random, x, y); placed++)
+    {
+        level.EntityAt(x, y) = entity;
+    }
+    return placed;
+}
+
+// The player starts on the free tile nearest to the center, which is cleared if everything is blocked
+static void PlacePlayer(Level &level)
+{
+    int centerX = level.width / 2;
+    int centerY = level.height / 2;
+    for (int radius = 0; radius < std::max(level.width, level.height); radius++)
+    {
+        for (int y = std::max(0, centerY - radius); y <= std::min(level.height - 1, centerY + radius); y++)
+        {
+            for (int x = std::max(0, centerX - radius); x <= std::min(level.width - 1, centerX + radius); x++)
+            {
+                if (level.GroundAt(x, y) != GROUND_BLOCK)
+                {
+                    level.EntityAt(x, y) = ENTITY_PLAYER;
+                    return;
+                }
+            }
+        }
+    }
+    level.GroundAt(centerX, centerY) = GROUND_DRY;
+    level.EntityAt(centerX, centerY) = ENTITY_PLAYER;
+}
+
+static Level Generate(const LevelOptions &options)
+{
+    Level level{options.width, options.height};
+    size_t area = static_cast<size_t>(level.width) * level.height;
+    level.ground.assign(area, GROUND_DRY);
+    level.entities.assign(area, ENTITY_NONE);
+
+    // One generator per stage, so changing one option doesn't reshuffle the rest of the level
+    std::mt19937 mazeRandom(options.seed);
+    std::mt19937 blockRandom(options.seed + 1);
+    std::mt19937 groundRandom(options.seed + 2);
+    std::mt19937 entityRandom(options.seed + 3);
+
+    if (options.maze > 0)
+    {
+        CarveMaze(level, options.maze, options.braid, mazeRandom);
+    }
+
+    std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+    for (auto &tile : level.ground)
+    {
+        if (tile == GROUND_DRY && chance(blockRandom) < options.blocks)
+        {
+            tile = GROUND_BLOCK;
+        }
+    }
+
+    PaintPatches(level, GROUND_SNOW, options.snow, groundRandom);
+    PaintPatches(level, GROUND_GRASS, options.grass, groundRandom);
+
+    PlacePlayer(level);
+    int defaultCount = static_cast<int>(std::max<size_t>(1, area / 256));
+    int fire = PlaceEntities(level, ENTITY_FIRE, options.fire >= 0 ? options.fire : defaultCount, entityRandom);
+    int ice = PlaceEntities(level, ENTITY_ICE, options.ice >= 0 ? options.ice : defaultCount, entityRandom);
+    int spring = PlaceEntities(level, ENTITY_SPRING, options.spring, entityRandom);
+    if (options.staffs)
+    {
+        PlaceEntities(level, ENTITY_FIRE_STAFF, 1, entityRandom);
+        PlaceEntities(level, ENTITY_ICE_STAFF, 1, entityRandom);
+    }
+
+    std::cout << "Placed " << fire << " fire, " << ice << " ice and " << spring << " spring elementals" << std::endl;
+    return level;
+}
+
+// Same layout as the shipped levels: one row per line, every value followed by a comma
+static bool WriteMatrix(const std::string &path, const Level &level, const std::vector<unsigned char> &values)
+{
+    FILE *file = fopen(path.c_str(), "w");
+    if (file == nullptr)
+    {
+        std::cerr << "Unable to write " << path << std::endl;
+        return false;
+    }
+
+    std::vector<char> line(static_cast<size_t>(level.width) * 2 + 1);
+    for (int y = 0; y < level.height; y++)
+    {
+        for (int x = 0; x < level.width; x++)
+        {
+            line[x * 2] = static_cast<char>('0' + values[static_cast<size_t>(y) * level.width + x]);
+            line[x * 2 + 1] = ',';
+        }
+        line[level.width * 2] = '\n';
+        fwrite(line.data(), 1, line.size(), file);
+    }
+    fclose(file);
+    return true;
+}
+
+static bool WriteTutorial(const std::string &path, const LevelOptions &options)
+{
+    FILE *file = fopen(path.c_str(), "w");
+    if (file == nullptr)
+    {
+        std::cerr << "Unable to write " << path << std::endl;
+        return false;
+    }
+    fprintf(file, "# Generated by levelgen, run it again with the same arguments to get this level back\n");
+    fprintf(file, "# --width %d --height %d --seed %u --blocks %g --maze %d --braid %g --snow %g --grass %g "
+                  "--fire %d --ice %d --spring %d%s\n",
+            options.width, options.height, options.seed, options.blocks, options.maze, options.braid,
+            options.snow, options.grass, options.fire, options.ice, options.spring, options.staffs ? "" : " --no-staffs");
+    fprintf(file, "[u, 10, 50] Generated level <color=0,255,155,255>%dx%d</color>, seed %u\n",
+            options.width, options.height, options.seed);
+    fclose(file);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    LevelOptions options;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--size") == 0 && hasValue)
+            options.width = options.height = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--width") == 0 && hasValue)
+            options.width = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--height") == 0 && hasValue)
+            options.height = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && hasValue)
+            options.seed = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        else if (strcmp(argv[i], "--blocks") == 0 && hasValue)
+            options.blocks = static_cast<float>(atof(argv[++i]));
+        else if (strcmp(argv[i], "--maze") == 0 && hasValue)
+            options.maze = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--braid") == 0 && hasValue)
+            options.braid = static_cast<float>(atof(argv[++i]));
+        else if (strcmp(argv[i], "--snow") == 0 && hasValue)
+            options.snow = static_cast<float>(atof(argv[++i]));
+        else if (strcmp(argv[i], "--grass") == 0 && hasValue)
+            options.grass = static_cast<float>(atof(argv[++i]));
+        else if (strcmp(argv[i], "--fire") == 0 && hasValue)
+            options.fire = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--ice") == 0 && hasValue)
+            options.ice = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--spring") == 0 && hasValue)
+            options.spring = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--no-staffs") == 0)
+            options.staffs = false;
+        else if (strcmp(argv[i], "--out") == 0 && hasValue)
+            options.out = argv[++i];
+        else
+        {
+            std::cerr << "Unknown argument " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    if (options.width < 1 || options.width > MAX_LEVEL_SIZE || options.height < 1 || options.height > MAX_LEVEL_SIZE)
+    {
+        std::cerr << "Levels go from 1x1 to " << MAX_LEVEL_SIZE << "x" << MAX_LEVEL_SIZE << std::endl;
+        return 1;
+    }
+    options.blocks = std::clamp(options.blocks, 0.0f, 1.0f);
+    options.braid = std::clamp(options.braid, 0.0f, 1.0f);
+    options.snow = std::clamp(options.snow, 0.0f, 1.0f);
+    options.grass = std::clamp(options.grass, 0.0f, 1.0f);
+
+    auto directory = std::filesystem::path(options.out).parent_path();
+    if (!directory.empty())
+    {
+        std::filesystem::create_directories(directory);
+    }
+
+    Level level = Generate(options);
+    bool written = WriteMatrix(options.out + "_ground.csv", level, level.ground) &&
+                   WriteMatrix(options.out + "_entities.csv", level, level.entities) &&
+                   WriteTutorial(options.out + "_tutorial.txt", options);
+    if (!written)
+    {
+        return 1;
+    }
+
+    std::cout << "Wrote " << options.out << "_{ground,entities}.csv (" << options.width << "x" << options.height << ")" << std::endl;
+    return 0;
+}